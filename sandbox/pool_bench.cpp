@@ -0,0 +1,50 @@
+// request/release cost of container::Pool for a range of sizes. the cost per 
+// pair should stay flat as the pool grows, including when only the last slot is free.
+// g++ -O2 -std=c++2a -fconcepts -I../src/core -I../include/thirdparty pool_bench.cpp -o pool_bench -lpthread -lvulkan
+#include <types/pool.hpp>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+struct Item
+{
+    bool isAvailable() const {return !inUse;}
+    void set(int v) {value = v;}
+    void activate() {inUse = true;}
+    void reset() {inUse = false;}
+    void print() const {}
+    bool inUse{false};
+    int value{0};
+};
+
+template <size_t Size>
+void bench()
+{
+    using Pool = sword::container::Pool<Item, Item, Size>;
+    static Pool pool;
+    constexpr int iterations = 1000000;
+
+    // fill all but one slot so a linear scan would have to walk the whole array
+    std::vector<typename Pool::Vessel> held;
+    for (size_t i = 0; i < Size - 1; i++) 
+        held.push_back(pool.request(0));
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) 
+    {
+        auto vessel = pool.request(i);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(end - start).count();
+    std::cout << "Size " << Size << ": " << ns / iterations << " ns per request/release" << '\n';
+}
+
+int main(int argc, const char *argv[])
+{
+    bench<8>();
+    bench<64>();
+    bench<200>();
+    bench<1024>();
+    bench<8192>();
+    return 0;
+}
@@ -1,16 +1,32 @@
 #include <application.hpp>
 #include <cstdint>
 #include <state/director.hpp>
+#include <command/shadersources.hpp>
+#include <util/defs.hpp>
 #include <event/event.hpp>
 #include <state/state.hpp>
 #include <thread>
 #include <util/debug.hpp>
+#include <util/profiler.hpp>
+#include <util/stringutil.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 
 namespace sword
 {
 
 constexpr std::uint16_t windowWidth{800};
 constexpr std::uint16_t windowHeight{800};
+constexpr int maxReplayEventsPerFrame{32}; //stays well inside the event pools
+constexpr uint64_t checkpointStride{4096}; //events between checkpoints
+
+static const char* paceNames[] = {"recorded", "fixed", "fast"};
+
+static std::chrono::nanoseconds replayStep(const ReplaySettings& settings)
+{
+    return std::chrono::nanoseconds(std::chrono::seconds(1)) / std::max(settings.fps, 1);
+}
 
 //TODO: we should not require window be initialized here. initialization of a window should be a command
 Application::Application(bool validation) :
@@ -20,31 +36,41 @@ Application::Application(bool validation) :
     renderer{context},
     offscreenDim{{windowWidth, windowHeight}},
     swapDim{{windowWidth, windowHeight}},
-    dirState{{stateEdits, cmdStack, cmdPools, stateRegister, context}, stateStack, window}
+    dirState{{stateEdits, cmdStack, cmdPools, stateRegister, context, framePacer}, stateStack, window}
 {
+    dispatcher.eventQueue.setOnPush([this](){ framePacer.wake(); });
+    dispatcher.fileWatcher.watchTree(SHADER_SRC, [](const std::string& path, bool added, bool isDir) {
+            command::shaderSources().update(path, added, isDir); },
+            []() { command::shaderSources().invalidate(); });
+    watchMetrics();
 }
 
-Application::Application(uint16_t w, uint16_t h, const std::string logfile, int event_reads) :
+Application::Application(uint16_t w, uint16_t h, const std::string logfile, int event_reads, ReplaySettings replay) :
     context{true},
-    window{w, h},
+    window{w, h, replay.headless},
     dispatcher{window},
     renderer{context},
     offscreenDim{{w, h}},
     swapDim{{w, h}},
     readlog{logfile},
-    dirState{{stateEdits, cmdStack, cmdPools, stateRegister, context}, stateStack, window}
+    dirState{{stateEdits, cmdStack, cmdPools, stateRegister, context, framePacer}, stateStack, window},
+    replaySettings{replay}
 {
+    dispatcher.eventQueue.setOnPush([this](){ framePacer.wake(); });
+    dispatcher.fileWatcher.watchTree(SHADER_SRC, [](const std::string& path, bool added, bool isDir) {
+            command::shaderSources().update(path, added, isDir); },
+            []() { command::shaderSources().invalidate(); });
+    watchMetrics();
     stateStack.push(&dirState);
     stateStack.top()->onEnter();
 
     if (readlog != "eventlog")
     {
         std::cout << "reading events from " << readlog << std::endl;
-        recordevents = true;
+        recordevents = !replay.headless; //benchmark runs shouldn't clobber the last session's log
         readevents = true;
     }
-    //if (readevents) readEvents(is, eventPops);
-    if (recordevents) std::remove(writelog.data());
+    //if (readevents) readEvents(eventPops);
 
     if (event_reads == 0)
         maxEventReads = INT32_MAX;
@@ -52,49 +78,78 @@ Application::Application(uint16_t w, uint16_t h, const std::string logfile, int
         maxEventReads = event_reads;
 }
 
+// the watcher thread wakes framePacer, which is destroyed before the dispatcher
+// that owns the watcher, so it has to be gone first
+Application::~Application()
+{
+    dispatcher.fileWatcher.shutdown();
+}
+
+void Application::watchMetrics()
+{
+    using util::metrics::watchPool;
+    watchPool(watches, "pool.cmd.loadFragShader", cmdPools.loadFragShader);
+    watchPool(watches, "pool.cmd.loadVertShader", cmdPools.loadVertShader);
+    watchPool(watches, "pool.cmd.setSpecFloat", cmdPools.setSpecFloat);
+    watchPool(watches, "pool.cmd.setSpecInt", cmdPools.setSpecInt);
+    watchPool(watches, "pool.cmd.addAttachment", cmdPools.addAttachment);
+    watchPool(watches, "pool.cmd.openWindow", cmdPools.openWindow);
+    watchPool(watches, "pool.cmd.createDescriptorSetLayout", cmdPools.createDescriptorSetLayout);
+    watchPool(watches, "pool.cmd.createPipelineLayout", cmdPools.createPipelineLayout);
+    watchPool(watches, "pool.cmd.prepareRenderFrames", cmdPools.prepareRenderFrames);
+    watchPool(watches, "pool.cmd.createGraphicsPipeline", cmdPools.createGraphicsPipeline);
+    watchPool(watches, "pool.cmd.createSwapchainRenderpass", cmdPools.createSwapchainRenderpass);
+    watchPool(watches, "pool.cmd.createOffscreenRenderpass", cmdPools.createOffscreenRenderpass);
+    watchPool(watches, "pool.cmd.createRenderLayer", cmdPools.createRenderLayer);
+    watchPool(watches, "pool.cmd.recordRenderCommand", cmdPools.recordRenderCommand);
+    watchPool(watches, "pool.cmd.createFrameDescriptorSets", cmdPools.createFrameDescriptorSets);
+    watchPool(watches, "pool.cmd.addFrameUniformBuffer", cmdPools.addFrameUniformBuffer);
+    watchPool(watches, "pool.cmd.updateFrameSamplers", cmdPools.updateFrameSamplers);
+    watchPool(watches, "pool.cmd.compileShader", cmdPools.compileShader);
+    watchPool(watches, "pool.cmd.compileShaderCode", cmdPools.compileShaderCode);
+    watchPool(watches, "pool.cmd.watchFile", cmdPools.watchFile);
+    watchPool(watches, "pool.cmd.saveSwapToPng", cmdPools.saveSwapToPng);
+    watchPool(watches, "pool.cmd.saveAttachmentToPng", cmdPools.saveAttachmentToPng);
+    watchPool(watches, "pool.cmd.bindUboData", cmdPools.bindUboData);
+    auto& reg = util::metrics::registry();
+    watches.push_back(reg.watch("queue.cmd.depth", [this]() { return int64_t(cmdStack.size()); }));
+    watches.push_back(reg.watch("queue.cmd.inFlight", [this]() { return int64_t(cmdGraph.inFlight()); }));
+}
+
 void Application::popState()
 {
     stateStack.top()->onExit();
     stateStack.pop();
+    routesDirty = true;
 }
 
 void Application::pushState(state::State* state)
 {
     stateStack.push(std::move(state));
+    routesDirty = true;
     if (state->getType() != state::StateType::leaf)
         state->onEnter();
 }
 
 void Application::pushCmd(command::Vessel command)
 {
-    cmdStack.push(std::move(command));
+    command::push(cmdStack, std::move(command));
 }
 
-void Application::recordEvent(event::Event* event, std::ofstream& os)
+void Application::recordEvent(const event::Event& event)
 {
-    if (event->getCategory() == event::Category::CommandLine)
-    {
-
-        os.open(writelog, std::ios::out | std::ios::binary | std::ios::app);
-        auto ce = static_cast<event::CommandLine*>(event);
-        ce->serialize(os);
-        os.close();
-    }
-    if (event->getCategory() == event::Category::Abort)
-    {
-
-        os.open(writelog, std::ios::out | std::ios::binary | std::ios::app);
-        auto ce = static_cast<event::Abort*>(event);
-        ce->serialize(os);
-        os.close();
-    }
+    eventLog.write(event, event.getCreationTime());
 }
 
-void Application::readEvents(std::ifstream& is, int eventPops)
+void Application::readEvents(int eventPops)
 {
-    is.open(readlog, std::ios::binary);
-    dispatcher.readEvents(is, eventPops);
-    is.close();
+    if (!replayLog.open(readlog))
+    {
+        std::cerr << "Application::readEvents: could not open " << readlog << '\n';
+        return;
+    }
+    dispatcher.readEvents(replayLog, eventPops);
+    replayLog.close();
 }
 
 void Application::pushDraw(render::RenderParms parms)
@@ -109,27 +164,29 @@ void Application::popDraw()
 
 void Application::launchWorkerThread()
 {
-    std::thread worker(&Application::executeCommands, this);
-    worker.detach();
+    cmdWorker = std::thread(&Application::executeCommands, this);
     SWD_DEBUG_MSG("Worker launched");
 }
 
 void Application::drainEventQueue()
 {
-    while (!dispatcher.eventQueue.empty())
+    SWD_PROFILE_SCOPE("Application::drainEventQueue");
+    static auto& eventAge = util::metrics::registry().histogram("event.age_us");
+    static auto& handleTime = util::metrics::registry().histogram("event.handle_us");
+    dispatcher.drainEvents([this](event::Any&& event)
     {
-        auto event = dispatcher.eventQueue.pop();
-        if (event)
-        {
-            if (recordevents) recordEvent(event.get(), os);
+        auto start = std::chrono::steady_clock::now();
+        eventAge.record(util::metrics::toMicros(start - event->getCreationTime()));
 
-            for (auto state : stateStack) 
-            {
-                state->handleEvent(event.get());
-                if (event->isHandled()) 
-                    break;
-            }
+        if (routesDirty)
+        {
+            router.rebuild(stateStack);
+            routesDirty = false;
         }
+        state::State::takeRedrawRequest();
+        auto handler = router.route(*event.get());
+        if (state::State::takeRedrawRequest())
+            pendingInputs.add(&presentLatencyFor(handler, *event.get()), event->getCreationTime());
 
         if (stateEdits.size() > 0)
         {
@@ -148,98 +205,430 @@ void Application::drainEventQueue()
             if (stateStack.top()->getType() == state::StateType::leaf)
                 stateStack.top()->onEnter();
         }
+        handleTime.record(util::metrics::toMicros(std::chrono::steady_clock::now() - start));
+    },
+    [this](const event::Event& event)
+    {
+        if (recordevents) recordEvent(event);
+    });
+    if (recordevents) eventLog.flush(); //one write per frame at most, and little to lose in a crash
+
+    auto dropped = dispatcher.eventQueue.dropped();
+    if (dropped != eventsDropped)
+    {
+        SWD_DEBUG_MSG("Event queue full. " << dropped - eventsDropped << " events dropped. Peak depth: " << dispatcher.eventQueue.highWaterMark());
+        eventsDropped = dropped;
+    }
+}
+
+// one histogram per state and kind of event, e.g. latency.present_us.Paint.MouseMotionEvent,
+// so a stroke and a drag of the view are timed apart
+util::metrics::Histogram& Application::presentLatencyFor(const state::State* handler, const event::Event& event)
+{
+    uint16_t kind = static_cast<uint16_t>(event.getCategory()) << 8;
+    if (event.getCategory() == event::Category::Window)
+        kind |= static_cast<uint16_t>(static_cast<const event::Window&>(event).getType());
+    auto& latency = presentLatency[{handler ? handler->getName() : nullptr, kind}];
+    if (!latency)
+    {
+        std::string name = "latency.present_us.";
+        name += handler ? handler->getName() : "unhandled";
+        name += '.';
+        name += event.getName();
+        latency = &util::metrics::registry().histogram(name);
     }
+    return *latency;
 }
 
 void Application::executeCommands()
 {
+    command::onCommandThread = true; //the consumer, it must never wait on its own queue
     while (1)
     {
-        if (!cmdStack.empty())
+        auto cmd = cmdStack.waitPop(); //sleeps until a command is pushed
+        if (cmd)
         {
-            cmdStack.reverse();
-        }
-        while (!cmdStack.empty())
-        {
-            auto cmd = cmdStack.pop();
-            if (cmd)
-            {
-                cmd->execute(this);
-                SWD_DEBUG_MSG(cmd->getName() << " executed.");
-                if (cmd->succeeded())
-                    cmd->onSuccess();
-            }
-            else
-                std::cout << "Recieved null cmd" << std::endl;
+            auto deps = cmd->getDependencies();
+            // std::function wants something copyable
+            auto shared = std::make_shared<command::Vessel>(std::move(cmd));
+            cmdGraph.submit(deps, [this, shared]() 
+            { 
+                command::onCommandThread = true;
+                runCommand(*shared); 
+                *shared = command::Vessel(); //back to its pool, which may push more commands
+                cmdStack.taskDone();
+            });
+            continue;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        cmdStack.taskDone();
+        if (stopWorker)
+            break;
+        std::cout << "Recieved null cmd" << std::endl;
+    }
+}
+
+void Application::runCommand(command::Vessel& cmd)
+{
+    static auto& latency = util::metrics::registry().histogram("command.latency_us");
+    static auto& executeTime = util::metrics::registry().histogram("command.execute_us");
+    auto start = std::chrono::steady_clock::now();
+    latency.record(util::metrics::toMicros(start - cmd->getRequestTime()));
+    {
+        SWD_PROFILE_SCOPE(cmd->getName());
+        cmd->execute(this);
+    }
+    executeTime.record(util::metrics::toMicros(std::chrono::steady_clock::now() - start));
+    SWD_TRACE_MSG(cmd->getName() << " executed.");
+    if (cmd->succeeded())
+    {
+        if (cmd->changesFrame())
+            framePacer.requestRedraw();
+        std::lock_guard<std::mutex> guard(successLock);
+        cmd->onSuccess();
     }
 }
 
+// the growable pools hand back chunks that have sat empty. idle frames still
+// come around every so often, so this runs even when nothing is happening
+void Application::trimPools()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastTrim < trimInterval)
+        return;
+    lastTrim = now;
+    cmdPools.compileShader.trim();
+}
+
 void Application::beginFrame()
 {
+    SWD_PROFILE_SCOPE("Application::beginFrame");
     for (auto& state : stateStack) 
     {
         state->beginFrame();
     }
 }
 
-void Application::endFrame()
+// returns true if we actually drew. frames where nothing asked for a redraw
+// skip submit and present
+bool Application::endFrame()
 {
+    SWD_PROFILE_SCOPE("Application::endFrame");
     for (auto& state : stateStack) 
     {
         state->endFrame();
     }
+    if (!framePacer.takeRedraw())
+        return false;
     if (!drawStack.empty())
     {
         auto parms = drawStack.top();
-        renderer.render(parms.getBufferId(), parms.getUboCount(), parms.getUboIndices());
+        parms.inputs = pendingInputs;
+        pendingInputs.clear();
+        renderer.render(parms);
+        return true;
+    }
+    return false;
+}
+
+// v1 logs carry no times, so their events are spread one frame apart
+bool Application::nextReplayRecord()
+{
+    event::LogRecord record;
+    if (eventsRead >= maxEventReads || !replayLog.next(record))
+    {
+        pendingRecord.reset();
+        return false;
+    }
+    if (replayLog.getVersion() == 1)
+        record.time = eventsRead * replayStep(replaySettings).count();
+    eventsRead++;
+    pendingRecord = record;
+    return true;
+}
+
+// hands the dispatcher whatever the log has due by this frame's virtual time.
+// false once the log is used up
+bool Application::replayFrame()
+{
+    if (!pendingRecord && !nextReplayRecord())
+        return false;
+    if (skimming)
+    {
+        skimFrame();
+        return true;
     }
+    bool seeking = replayPosition() < replaySettings.seek;
+    if (seeking || replaySettings.pace == ReplayPace::fast)
+        replayClock = std::max(replayClock, std::chrono::nanoseconds(pendingRecord->time)); //skip the quiet stretch
+    framePacer.setClock(replayClock);
+    int released = 0;
+    while (pendingRecord && pendingRecord->time <= uint64_t(replayClock.count()) && released < maxReplayEventsPerFrame)
+    {
+        replayedTime = pendingRecord->time;
+        dispatcher.replay(*pendingRecord);
+        released++;
+        nextReplayRecord();
+    }
+    if (seeking && replayPosition() >= replaySettings.seek)
+    {
+        std::cout << "Reached event " << replayPosition() << '\n';
+        framePacer.setTargetFramePeriod(replayFramePeriod());
+    }
+    replayClock += replayStep(replaySettings);
+    replayFrames++;
+    return true;
+}
+
+util::FramePacer::Clock::duration Application::replayFramePeriod() const
+{
+    if (replaySettings.pace == ReplayPace::recorded)
+        return replayStep(replaySettings);
+    return util::FramePacer::Clock::duration::zero();
+}
+
+// finds the checkpoint to start from. the events before it still get replayed,
+// since they are what builds the renderer's objects and the state stack, but
+// only skimmed: see skimFrame
+void Application::beginSeek()
+{
+    framePacer.setTargetFramePeriod(util::FramePacer::Clock::duration::zero());
+    event::CheckpointReader reader;
+    const event::CheckpointReader::Entry* entry = nullptr;
+    if (reader.open(readlog + ".ckpt"))
+        entry = reader.nearest(replaySettings.seek);
+    if (!entry || entry->event == 0 || !reader.load(*entry, seekCheckpoint))
+    {
+        std::cout << "No checkpoint before event " << replaySettings.seek << ", replaying from the start" << '\n';
+        return;
+    }
+    skimUntil = entry->event;
+    skimming = true;
+    std::cout << "Seeking to event " << replaySettings.seek << " from the checkpoint at event " << skimUntil << '\n';
+}
+
+// motion is left out, and nothing gets drawn. the checkpoint puts back
+// everything motion would have changed
+void Application::skimFrame()
+{
+    int released = 0;
+    while (pendingRecord && replayPosition() < skimUntil && released < maxReplayEventsPerFrame)
+    {
+        auto& record = *pendingRecord;
+        replayedTime = record.time;
+        if (record.category != event::Category::Window || record.windowType != event::WindowEventType::Motion)
+        {
+            dispatcher.replay(record);
+            released++;
+        }
+        nextReplayRecord();
+    }
+    replayClock = std::chrono::nanoseconds(replayedTime);
+    framePacer.setClock(replayClock);
+    replayFrames++;
+}
+
+void Application::restoreCheckpoint()
+{
+    skimming = false;
+    seekCheckpoint.cursor = 0;
+    for (auto state : stateStack) 
+        state->restoreCheckpoint(seekCheckpoint);
+    if (!seekCheckpoint.pixels.empty())
+        renderer.copyHostToAttachment(
+                seekCheckpoint.pixels.data(), seekCheckpoint.pixels.size(), seekCheckpoint.attachment, 
+                vk::Rect2D{{0, 0}, {seekCheckpoint.width, seekCheckpoint.height}});
+    replayClock = std::chrono::nanoseconds(seekCheckpoint.time);
+    std::cout << "Restored the checkpoint at event " << seekCheckpoint.event << '\n';
+    seekCheckpoint = event::Checkpoint{};
+}
+
+// checkpoints are numbered in the log they belong to: the one being recorded,
+// or else the one being replayed
+uint64_t Application::checkpointPosition() const
+{
+    return recordevents ? eventLog.eventCount() : replayPosition();
+}
+
+// called between frames with no commands running, so the renderer is ours
+void Application::takeCheckpoint()
+{
+    auto checkpoint = std::make_shared<event::Checkpoint>();
+    checkpoint->event = checkpointPosition();
+    checkpoint->time = recordevents ? eventLog.lastEventTime() : replayedTime;
+    nextCheckpoint = checkpoint->event + checkpointStride;
+    for (auto state : stateStack) 
+        state->saveCheckpoint(*checkpoint);
+    if (checkpoint->state.empty() && checkpoint->attachment.empty())
+        return; //nothing worth keeping yet
+    if (!checkpoint->attachment.empty())
+    {
+        auto block = renderer.copyAttachmentToHost(
+                checkpoint->attachment, vk::Rect2D{{0, 0}, {checkpoint->width, checkpoint->height}});
+        auto pixels = static_cast<const uint8_t*>(block->pHostMemory);
+        checkpoint->pixels.assign(pixels, pixels + size_t(checkpoint->width) * checkpoint->height * 4);
+        renderer.popBufferBlock();
+    }
+    // compressing takes a while, so it goes to the command threads
+    cmdGraph.submit(render::Dependencies{{}, {"checkpointLog"}}, [this, checkpoint]() 
+    { 
+        checkpointLog.write(*checkpoint); 
+    });
+}
+
+void Application::endReplay()
+{
+    reportReplay();
+    replayLog.close();
+    readevents = false;
+    framePacer.setTargetFramePeriod(livePeriod);
+    framePacer.resumeClock();
+}
+
+void Application::reportReplay() const
+{
+    auto& reg = util::metrics::registry();
+    auto events = reg.histogram("event.handle_us").summarize();
+    auto frames = reg.histogram("replay.frame_us").summarize();
+    auto commands = reg.histogram("command.execute_us").summarize();
+    auto wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - replayStart).count();
+    auto virtualMs = std::chrono::duration<double, std::milli>(replayClock).count();
+    auto pace = paceNames[static_cast<int>(replaySettings.pace)];
+
+    auto line = [](std::ostream& os, const char* name, const util::metrics::Histogram::Summary& s)
+    {
+        os << std::left << std::setw(16) << name << "n " << s.count 
+           << "  mean " << s.mean << "  p50 " << s.p50 << "  p99 " << s.p99 << "  max " << s.max << '\n';
+    };
+    std::cout << util::makeHeader("Replay") << '\n' << std::fixed << std::setprecision(1)
+        << readlog << ": " << eventsRead << " events in " << replayFrames << " frames, " 
+        << pace << " at " << replaySettings.fps << " fps" << '\n'
+        << "wall " << wallMs << " ms, virtual " << virtualMs << " ms" << '\n';
+    line(std::cout, "event_us", events);
+    line(std::cout, "frame_us", frames);
+    line(std::cout, "command_us", commands);
+    std::cout << std::right << std::defaultfloat;
+
+    if (replaySettings.report.empty())
+        return;
+    std::ofstream os(replaySettings.report, std::ios::app);
+    if (!os.is_open())
+    {
+        std::cerr << "Application::reportReplay: could not open " << replaySettings.report << '\n';
+        return;
+    }
+    if (os.tellp() == 0)
+        os << "log,pace,fps,events,frames,wall_ms,virtual_ms,"
+              "event_p50_us,event_p99_us,frame_p50_us,frame_p99_us,frame_max_us,command_p50_us,command_p99_us\n";
+    os << std::fixed << std::setprecision(1)
+       << readlog << ',' << pace << ',' << replaySettings.fps << ',' << eventsRead << ',' << replayFrames << ','
+       << wallMs << ',' << virtualMs << ',' << events.p50 << ',' << events.p99 << ','
+       << frames.p50 << ',' << frames.p99 << ',' << frames.max << ','
+       << commands.p50 << ',' << commands.p99 << '\n';
 }
 
 void Application::run(bool pollEvents)
 {
-    if (pollEvents)
+    if (pollEvents && !window.isHeadless()) //headless runs only take input from their log
     {
         dispatcher.pollEvents();
     }
 
+    if (readevents && !replayLog.open(readlog))
+    {
+        std::cerr << "Application::run: could not open " << readlog << ", nothing to replay" << '\n';
+        readevents = false;
+    }
+    if (recordevents && !eventLog.isOpen() && !eventLog.open(writelog))
+    {
+        std::cerr << "Application::run: could not open " << writelog << ", not recording" << '\n';
+        recordevents = false;
+    }
     if (readevents)
-        is.open(readlog, std::ios::binary);
+    {
+        livePeriod = framePacer.targetFramePeriod();
+        framePacer.setTargetFramePeriod(replayFramePeriod());
+        framePacer.setClock(replayClock);
+        replayStart = std::chrono::steady_clock::now();
+        if (replaySettings.seek)
+            beginSeek();
+    }
+    std::string checkpointPath;
+    if (recordevents)
+        checkpointPath = writelog + ".ckpt";
+    else if (readevents && replaySettings.checkpoints && !replaySettings.seek) //a seek reads the file this would truncate
+        checkpointPath = readlog + ".ckpt";
+    if (!checkpointPath.empty() && !checkpointLog.open(checkpointPath))
+        std::cerr << "Application::run: could not open " << checkpointPath << ", no checkpoints" << '\n';
+    nextCheckpoint = checkpointStride;
 
     launchWorkerThread();
 
+    auto& frameTime = util::metrics::registry().histogram("frame.time_us"); //work only, not the sleep
+    auto& replayFrameTime = util::metrics::registry().histogram("replay.frame_us");
+    auto& idleFrames = util::metrics::registry().counter("frame.idle");
+
     bool keepRunnning = true;
     while (keepRunnning)
     {
+        framePacer.beginFrame();
         if (!pollEvents)
             keepRunnning = false; //only runs once
-        if (readevents && eventsRead < maxEventReads)
-        {
-            dispatcher.readEvent(is);
-            eventsRead++;
-        }
+        bool replaying = readevents && replayFrame();
 
         beginFrame();
 
         drainEventQueue();
 
-        //commands will be executed by worker thread
+        //commands will be executed by worker thread. a replayed frame waits for 
+        //them, so what it draws depends on the log and nothing else
+        if (replaying)
+            cmdStack.waitIdle();
+        if (replaying && skimming)
+        {
+            framePacer.takeRedraw(); //nothing worth drawing until the checkpoint is back
+            pendingInputs.clear();
+            if (replayPosition() >= skimUntil)
+                restoreCheckpoint();
+        }
+
+        bool drew = endFrame();
 
-        endFrame();
+        if (checkpointLog.isOpen() && !skimming && checkpointPosition() >= nextCheckpoint && cmdStack.isIdle())
+            takeCheckpoint();
+        trimPools();
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        //sleeps off the rest of the frame, or until something happens if we had nothing to do
+        framePacer.endFrame(!drew && !replaying);
+        if (replaying)
+            replayFrameTime.record(util::metrics::toMicros(framePacer.lastFrameTime()));
+        if (drew)
+            frameTime.record(util::metrics::toMicros(framePacer.lastFrameTime()));
+        else
+            idleFrames.add();
+
+        if (readevents && !replaying)
+        {
+            endReplay();
+            if (window.isHeadless())
+                keepRunnning = false;
+        }
     }
     if (readevents)
-        is.close();
+        endReplay();
+    eventLog.flush();
+    cmdStack.waitIdle();
+    cmdGraph.waitIdle(); //checkpoints still being written
+    checkpointLog.close();
+    stopWorker = true;
+    cmdStack.push(command::Vessel());
+    cmdWorker.join();
 }
 
-// in case you forget. we need to be able to handle cmdPtrs that end up pushing 
-// new commands to the stack when they get destructed (returned the pool). so using a stack for the commands
-// makes sense. but we also want the execution order to match the order in which the
-// commands were pushed. so we need to reverse the stack before we start iterating over it
-// this will be interesting to profile. i don't know yet how big the cmdStack is likely to get in practice.
-// and whether iteraticing over it effectively twice will make a difference ultimately.
+// in case you forget. commands can end up pushing new commands when they
+// succeed or get destructed (returned to the pool), which happens on a command
+// thread. cmdStack is a FIFO so execution order matches push order without any
+// reversing. pushes from command threads go to its overflow when it is full
+// instead of waiting, see command::push.
 
 
 }; // namespace sword
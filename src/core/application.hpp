@@ -5,6 +5,7 @@
 #include <state/director.hpp>
 #include <state/statetypes.hpp>
 #include <state/editstack.hpp>
+#include <state/router.hpp>
 #include <render/ubotypes.hpp>
 #include <render/context.hpp>
 #include <render/surface/window.hpp>
@@ -12,15 +13,42 @@
 #include <string>
 #include <command/commandpools.hpp>
 #include <event/dispatcher.hpp>
+#include <util/framepacer.hpp>
+#include <util/threadpool.hpp>
+#include <render/dependencygraph.hpp>
+#include <util/metrics.hpp>
+#include <event/checkpoint.hpp>
+#include <map>
+#include <optional>
+#include <thread>
 
 namespace sword
 {
 
+// how a replay hands out the events in its log. every pace runs the log on a
+// virtual clock that steps a fixed amount per frame, and waits for the commands
+// each frame triggers before drawing it, so a log replays the same way every time.
+// recorded sleeps between frames to keep the timing of the original session,
+// fixed does the same frames without sleeping, and fast also skips the frames
+// in which nothing happened
+enum class ReplayPace : uint8_t {recorded, fixed, fast};
+
+struct ReplaySettings
+{
+    ReplayPace pace{ReplayPace::recorded};
+    int fps{60}; //frames per second of virtual time
+    bool headless{false}; //no X server. quits once the log is done
+    std::string report; //file to append a line of timings to when the replay ends
+    uint64_t seek{0}; //get to this event quickly, from the nearest checkpoint in <log>.ckpt
+    bool checkpoints{false}; //when not recording, write <log>.ckpt for the log being replayed
+};
+
 class Application
 {
 public:
     Application(bool validate = true);
-    Application(uint16_t w, uint16_t h, const std::string logfile, int eventPops = 0);
+    Application(uint16_t w, uint16_t h, const std::string logfile, int eventPops = 0, ReplaySettings = {});
+    ~Application();
     void run(bool pollEvents);
     void popState();
     void pushState(state::State* const);
@@ -29,8 +57,10 @@ public:
     void pushDraw(const render::RenderParms);
     void popDraw();
 
-    void readEvents(std::ifstream&, int eventPops);
-    void recordEvent(event::Event* event, std::ofstream& os);
+    void setTargetFps(int fps) { framePacer.setTargetFps(fps); }
+
+    void readEvents(int eventPops);
+    void recordEvent(const event::Event& event);
 
 
     render::Context context;
@@ -39,8 +69,8 @@ public:
     event::EventDispatcher dispatcher;
     vk::Extent2D offscreenDim;
     vk::Extent2D swapDim;;
-    std::ofstream os;
-    std::ifstream is;
+    event::LogWriter eventLog;
+    event::LogReader replayLog;
 
     CommandPools cmdPools;
     state::Register stateRegister;
@@ -55,21 +85,66 @@ private:
     
     state::EditStack stateEdits;
     StateStack stateStack;
+    state::Router router;
+    bool routesDirty{true}; //the router is rebuilt before the next event once the stack changes
     command::Queue cmdStack;
+    util::FramePacer framePacer;
+    std::thread cmdWorker;
+    std::atomic<bool> stopWorker{false};
+    util::ThreadPool cmdThreads;
+    render::DependencyGraph cmdGraph{cmdThreads};
+    std::mutex successLock; // success callbacks write into state, so one at a time
 
     Stack<render::RenderParms> drawStack;
+    render::InputStamps pendingInputs; //inputs that asked for a redraw we haven't presented yet
+    std::map<std::pair<const char*, uint16_t>, util::metrics::Histogram*> presentLatency;
+    util::metrics::Histogram& presentLatencyFor(const state::State* handler, const event::Event&);
 
     state::Director dirState;
 
     void launchWorkerThread();
 
     void beginFrame();
-    void endFrame();
+    bool endFrame();
+    void trimPools();
+    static constexpr auto trimInterval = std::chrono::seconds(1);
+    std::chrono::steady_clock::time_point lastTrim{};
     void drainEventQueue();
     void executeCommands();
+    void runCommand(command::Vessel&);
 
     int maxEventReads{0};
     int eventsRead{0};
+    size_t eventsDropped{0};
+
+    ReplaySettings replaySettings;
+    std::optional<event::LogRecord> pendingRecord;
+    std::chrono::nanoseconds replayClock{0};
+    uint64_t replayFrames{0};
+    std::chrono::steady_clock::time_point replayStart;
+    util::FramePacer::Clock::duration livePeriod; //frame period to go back to after the replay
+
+    uint64_t replayedTime{0}; //log time of the last event handed out
+    bool nextReplayRecord();
+    bool replayFrame();
+    void endReplay();
+    void reportReplay() const;
+    uint64_t replayPosition() const { return eventsRead - (pendingRecord ? 1 : 0); }
+    util::FramePacer::Clock::duration replayFramePeriod() const;
+
+    event::CheckpointWriter checkpointLog;
+    uint64_t nextCheckpoint{0};
+    event::Checkpoint seekCheckpoint;
+    uint64_t skimUntil{0};
+    bool skimming{false};
+    void beginSeek();
+    void skimFrame();
+    void restoreCheckpoint();
+    uint64_t checkpointPosition() const;
+    void takeCheckpoint();
+
+    void watchMetrics();
+    std::vector<util::metrics::Watch> watches; //keep last, these point into the members above
 };
 
 }; // namespace sword
@@ -2,7 +2,10 @@
 #define COMMAND_COMMAND_H_
 
 #include <functional>
+#include <chrono>
+#include <optional>
 #include <util/debug.hpp>
+#include <render/dependencygraph.hpp>
 
 #define CMD_BASE(name) \
     void execute(Application*) override;\
@@ -32,13 +35,18 @@ public:
     virtual void execute(Application*) = 0;
     virtual const char* getName() const = 0;
     virtual state::Report* makeReport() const { return nullptr; };
+    // commands that don't declare what they touch run on their own, in order
+    virtual std::optional<render::Dependencies> getDependencies() const { return std::nullopt; }
+    // whether what we draw is different once this has succeeded
+    virtual bool changesFrame() const { return false; }
     constexpr bool isAvailable() const {return !inUse;}
     template <typename... Args> void set(Args... args) {}
     virtual void reset() {
         inUse = false; 
-        SWD_DEBUG_MSG("");
+        SWD_TRACE_MSG("");
     }
-    void activate() {inUse = true;}
+    void activate() {inUse = true; requested = std::chrono::steady_clock::now();}
+    std::chrono::steady_clock::time_point getRequestTime() const {return requested;}
     void setSuccessFn(SuccessFn fn) { successFn = fn; }
     constexpr bool succeeded() {return success_status;}
     void onSuccess() {
@@ -57,6 +65,7 @@ protected:
 private:
     bool inUse{false};
     bool success_status{false};
+    std::chrono::steady_clock::time_point requested;
 };
 
 } // namespace command
@@ -13,6 +13,9 @@ namespace sword
 template<typename T>
 using CommandPool = command::Pool<T, 5>;
 
+// a whole directory of shaders can be compiled at once, so this one grows
+using CompileShaderPool = command::SlabPool<command::CompileShader, 8>;
+
 //not including vocab commands
 struct CommandPools
 {
@@ -34,7 +37,7 @@ struct CommandPools
     CommandPool<command::CreateFrameDescriptorSets> createFrameDescriptorSets;
     CommandPool<command::AddFrameUniformBuffer> addFrameUniformBuffer;
     CommandPool<command::UpdateFrameSamplers> updateFrameSamplers;
-    CommandPool<command::CompileShader> compileShader;
+    CompileShaderPool compileShader;
     CommandPool<command::CompileShaderCode> compileShaderCode;
     CommandPool<command::WatchFile> watchFile;
     CommandPool<command::SaveSwapToPng> saveSwapToPng;
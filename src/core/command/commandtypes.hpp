@@ -1,3 +1,6 @@
+#ifndef COMMAND_COMMANDTYPES_HPP
+#define COMMAND_COMMANDTYPES_HPP
+
 #include <command/command.hpp>
 #include <memory>
 #include <functional>
@@ -12,15 +15,33 @@ namespace command
 {
 
 using Vessel = container::PoolVessel<Command>;
-using Queue = container::LockingQueue<Vessel, 50>;
+using Queue = container::BlockingQueue<Vessel, 64>;
+
+// set on the threads that run commands and hand them back to their pools. the
+// main thread may wait on those, so anything they push goes through
+// pushOrDefer rather than waiting for room
+inline thread_local bool onCommandThread{false};
+
+inline void push(Queue& queue, Vessel cmd)
+{
+    if (onCommandThread)
+        queue.pushOrDefer(std::move(cmd));
+    else
+        queue.push(std::move(cmd));
+}
 
 template <typename T, size_t N>
 using Pool = container::Pool<T, Command, N>;
 
+template <typename T, size_t ChunkSize>
+using SlabPool = container::SlabPool<T, Command, ChunkSize>;
+
 } // namespace command
 
 } // namespace sword
 
+#endif /* end of include guard: COMMAND_COMMANDTYPES_HPP */
+
 //template <typename T>
 //class CommandPool
 //{
@@ -0,0 +1,56 @@
+#include "includegraph.hpp"
+#include <filesystem>
+
+namespace sword
+{
+
+namespace command
+{
+
+std::string IncludeGraph::normal(const std::string& path)
+{
+    return std::filesystem::path(path).lexically_normal().string();
+}
+
+void IncludeGraph::record(const std::string& sourcePath, const std::vector<std::string>& files)
+{
+    auto source = normal(sourcePath);
+    std::lock_guard<std::mutex> guard(lock);
+    auto& current = includes[source];
+    for (const auto& file : current) 
+    {
+        auto it = includers.find(file);
+        if (it == includers.end()) continue;
+        it->second.erase(source);
+        if (it->second.empty())
+            includers.erase(it);
+    }
+    current.clear();
+    for (const auto& f : files) 
+    {
+        auto file = normal(f);
+        if (file == source) continue;
+        current.push_back(file);
+        includers[file].insert(source);
+    }
+}
+
+std::vector<std::string> IncludeGraph::dependents(const std::string& path) const
+{
+    auto file = normal(path);
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = includers.find(file);
+    if (it == includers.end())
+        return {};
+    return {it->second.begin(), it->second.end()};
+}
+
+IncludeGraph& includeGraph()
+{
+    static IncludeGraph graph;
+    return graph;
+}
+
+}; // namespace command
+
+}; // namespace sword
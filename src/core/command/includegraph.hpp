@@ -0,0 +1,40 @@
+#ifndef COMMAND_INCLUDEGRAPH_HPP
+#define COMMAND_INCLUDEGRAPH_HPP
+
+//imp: command/includegraph.cpp
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace sword
+{
+
+namespace command
+{
+
+// which shader sources pull in which files, as of their last compile. a
+// compile replaces its source's includes wholesale, so a dropped #include
+// stops the source being reloaded for that file. paths are kept lexically
+// normal, so callers may pass them however they were built
+class IncludeGraph
+{
+public:
+    void record(const std::string& source, const std::vector<std::string>& includes);
+    std::vector<std::string> dependents(const std::string& file) const; //the sources, not including file itself
+    static std::string normal(const std::string& path);
+private:
+    mutable std::mutex lock; //compiles record from command workers
+    std::unordered_map<std::string, std::vector<std::string>> includes; //by source
+    std::unordered_map<std::string, std::unordered_set<std::string>> includers; //by included file
+};
+
+IncludeGraph& includeGraph();
+
+}; // namespace command
+
+}; // namespace sword
+
+#endif /* end of include guard: COMMAND_INCLUDEGRAPH_HPP */
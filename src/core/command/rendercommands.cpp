@@ -18,7 +18,7 @@ void PrepareRenderFrames::execute(Application* app)
 
 void LoadFragShader::execute(Application* app)
 {
-    app->renderer.loadFragShader(SHADER_DIR + std::string("/") + shaderName, shaderName);
+    app->renderer.loadFragShader(shaderName);
     success();
 }
 
@@ -27,9 +27,14 @@ state::Report* LoadFragShader::makeReport() const
     return new state::ShaderReport(shaderName, ShaderType::frag, 0, 0, 0, 0);
 }
 
+std::optional<render::Dependencies> LoadFragShader::getDependencies() const
+{
+    return render::Dependencies{{}, {"frag:" + shaderName}};
+}
+
 void LoadVertShader::execute(Application* app)
 {
-    app->renderer.loadVertShader(SHADER_DIR + std::string("/") + shaderName, shaderName);
+    app->renderer.loadVertShader(shaderName);
     success();
 }
 
@@ -38,6 +43,11 @@ state::Report* LoadVertShader::makeReport() const
     return new state::ShaderReport(shaderName, ShaderType::vert, 0, 0, 0, 0);
 }
 
+std::optional<render::Dependencies> LoadVertShader::getDependencies() const
+{
+    return render::Dependencies{{}, {"vert:" + shaderName}};
+}
+
 void SetSpecFloat::execute(Application* app)
 {
     if (type == ShaderType::frag)
@@ -194,6 +204,14 @@ state::Report* CreateGraphicsPipeline::makeReport() const
             renderArea.offset.x, renderArea.offset.y, renderArea.extent.width, renderArea.extent.height, is3d);
 }
 
+std::optional<render::Dependencies> CreateGraphicsPipeline::getDependencies() const
+{
+    if (report) return std::nullopt; // recreation waits on the device, so keep it on its own
+    return render::Dependencies{
+        {"vert:" + vertshader, "frag:" + fragshader, "pipelineLayout:" + pipelineLayout, "renderPass:" + renderpass},
+        {"pipeline:" + name}};
+}
+
 void CreateRenderLayer::execute(Application* app)
 {
     app->renderer.createRenderLayer(attachment, renderpass, pipeline, drawParms);
@@ -25,6 +25,7 @@ public:
     CMD_BASE("loadFragShader");
     void set(std::string name) {shaderName = name;}
     state::Report* makeReport() const override;
+    std::optional<render::Dependencies> getDependencies() const override;
 private:
     std::string shaderName;
 };
@@ -35,6 +36,7 @@ public:
     CMD_BASE("loadVertShader");
     void set(std::string name) {shaderName = name;}
     state::Report* makeReport() const override;
+    std::optional<render::Dependencies> getDependencies() const override;
 private:
     std::string shaderName;
 };
@@ -43,6 +45,7 @@ class SetSpecFloat: public Command
 {
 public:
     CMD_BASE("setSpecFloat");
+    bool changesFrame() const override { return true; }
     void set(std::string name, ShaderType t, float first, float second) {
         shaderName = name; type = t; x = first; y = second;}
     state::Report* makeReport() const override;
@@ -57,6 +60,7 @@ class SetSpecInt: public Command
 {
 public:
     CMD_BASE("setSpecInt");
+    bool changesFrame() const override { return true; }
     inline void set(std::string name, ShaderType t, int first, int second) {
         shaderName = name; type = t; x = first; y = second;}
     state::Report* makeReport() const override;
@@ -89,6 +93,7 @@ class OpenWindow : public Command
 {
 public:
     CMD_BASE("openWindow")
+    bool changesFrame() const override { return true; }
 };
 
 class SetOffscreenDim : public Command
@@ -140,6 +145,7 @@ class CreateGraphicsPipeline : public Command
 {
 public:
     CMD_BASE("createGraphicsPipeline");
+    bool changesFrame() const override { return true; }
     void set(
             std::string name,
             std::string pipelineLayout,
@@ -188,6 +194,7 @@ public:
     }
 
     state::Report* makeReport() const override;
+    std::optional<render::Dependencies> getDependencies() const override;
 private:
     std::string name{"default"};
     std::string pipelineLayout{"default"};
@@ -226,6 +233,7 @@ class CreateRenderLayer : public Command
 {
 public:
     CMD_BASE("createRenderLayer");
+    bool changesFrame() const override { return true; }
     void set(
             std::string attachName,
             std::string renderpassName,
@@ -264,6 +272,7 @@ class RecordRenderCommand : public Command
 {
 public:
     CMD_BASE("recordRenderCommand");
+    bool changesFrame() const override { return true; }
     void set(int index, std::vector<uint32_t> renderLayers)
     {
         this->cmdBufferId = index;
@@ -308,6 +317,7 @@ class BindUboData : public Command
 public:
     void execute(Application* app) override;
     const char* getName() const override {return "BindUboData";};
+    bool changesFrame() const override { return true; }
     void set(void* address, int size) { 
         this->address = address, this->size = size; this->index = 0; }
     void set(void* address, int size, int index) { 
@@ -323,6 +333,7 @@ class UpdateFrameSamplers : public Command
 {
 public:
     CMD_BASE("updateFrameSamplers");
+    bool changesFrame() const override { return true; }
     void set(std::vector<const vk::Image*> imagePtrs, uint32_t b) { this->imagePtrs = imagePtrs; binding = b;}
     void set(std::vector<std::string> attachmentsNamesArg, uint32_t b) { this->attachmentNames = attachmentsNamesArg; binding = b;}
 private:
@@ -353,6 +364,7 @@ class PushDraw : public Command
 {
 public:
     CMD_BASE("pushDraw");
+    bool changesFrame() const override { return true; }
     void set(render::RenderParms parms)
     {
         renderParms = parms;
@@ -368,6 +380,7 @@ class PopDraw : public Command
 {
 public:
     CMD_BASE("popRenderCommand");
+    bool changesFrame() const override { return true; }
 private:
 //    uint32_t renderCommandId{0};
 //    int uboCount{0};
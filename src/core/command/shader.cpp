@@ -1,5 +1,6 @@
 #include "shader.hpp"
-#include "libshaderc_util/file_finder.h"
+#include "includegraph.hpp"
+#include "shadersources.hpp"
 #include "shaderc/shaderc.hpp"
 #include <cstdlib>
 #include <iostream>
@@ -10,6 +11,9 @@
 #include <fstream>
 #include <application.hpp>
 #include <util/debug.hpp>
+#include <util/profiler.hpp>
+#include <util/spirvcache.hpp>
+#include <util/metrics.hpp>
 
 namespace sword
 {
@@ -17,20 +21,96 @@ namespace sword
 namespace command
 {
 
-CompileShader::CompileShader()
+// anything we set on the compile options besides the includer. it is part of
+// the cache key, so change it whenever the options change
+static constexpr std::string_view optionsKey{"default"};
+
+// the Makefile sets this from the shaderc library the linker finds. failing
+// that, glslang's headers may say which release we build against. without
+// either we can't tell one shaderc from the next, so nothing is cached
+#ifndef SWD_SHADERC_VERSION
+#define SWD_SHADERC_VERSION ""
+#endif
+#if __has_include(<glslang/build_info.h>)
+#include <glslang/build_info.h>
+#define SWD_STRINGIFY_(x) #x
+#define SWD_STRINGIFY(x) SWD_STRINGIFY_(x)
+#define SWD_GLSLANG_VERSION "glslang" SWD_STRINGIFY(GLSLANG_VERSION_MAJOR) "." \
+    SWD_STRINGIFY(GLSLANG_VERSION_MINOR) "." SWD_STRINGIFY(GLSLANG_VERSION_PATCH) GLSLANG_VERSION_FLAVOR
+#else
+#define SWD_GLSLANG_VERSION ""
+#endif
+
+// the shaderc build plus the spirv version it targets. an upgrade of shaderc
+// or glslang changes the first even when the second stays put
+static std::string shadercVersion()
 {
-    // we could make the file_finder a static member... because it will be the same for all instantiations of this class.
-    // not sure if that would affect thread safety though...
-    std::unique_ptr<shaderc::CompileOptions::IncluderInterface> includer = std::make_unique<glslc::FileIncluder>(&file_finder);
-    compileOptions.SetIncluder(std::move(includer));
-    std::filesystem::recursive_directory_iterator iter{src_path};
-    for (const auto& d : iter) 
+    std::string_view build = SWD_SHADERC_VERSION;
+    if (build.empty())
+        build = SWD_GLSLANG_VERSION;
+    if (build.empty())
+    {
+        SWD_LOG(warn, "spirv cache off: no shaderc version to key it on, every shader compiles from source");
+        return {};
+    }
+    unsigned int version, revision;
+    shaderc_get_spv_version(&version, &revision);
+    return std::string(build) + "/spv" + std::to_string(version) + "." + std::to_string(revision);
+}
+
+// one compiler per command worker, so compiles running side by side never
+// contend on whatever glslang state a shared compiler keeps
+static const shaderc::Compiler& threadCompiler()
+{
+    thread_local const shaderc::Compiler compiler{};
+    return compiler;
+}
+
+// spirv for source, out of the disk cache if the same preprocessed text has
+// been compiled before with the same kind, options and shaderc. preprocessing
+// pulls in every include, so an edit to one of those is a miss too
+static bool compileCached(const std::string& source, shaderc_shader_kind kind,
+        const char* name, const shaderc::CompileOptions& options, std::vector<uint32_t>& code)
+{
+    static const std::string version = shadercVersion();
+    static auto& hits = util::metrics::registry().counter("shader.cache.hit");
+    static auto& misses = util::metrics::registry().counter("shader.cache.miss");
+    const auto& compiler = threadCompiler();
+    const bool cached = !version.empty();
+    util::SpirvCache::Key key{};
+    if (cached)
     {
-        if (std::filesystem::is_directory(d.path()))
+        auto preprocessed = [&]() {
+            SWD_PROFILE_SCOPE("CompileShader::preprocess");
+            return compiler.PreprocessGlsl(source, kind, name, options);
+        }();
+        if (preprocessed.GetCompilationStatus() != shaderc_compilation_status_success)
         {
-            file_finder.search_path().push_back(d.path());
+            std::cerr << "CompileShader::execute: failed to preprocess. Error message: " << preprocessed.GetErrorMessage() << '\n';
+            return false;
         }
+        std::string_view text(preprocessed.cbegin(), preprocessed.cend() - preprocessed.cbegin());
+        key = util::SpirvCache::key({text, std::to_string(kind), optionsKey, version});
+        if (util::spirvCache().load(key, code))
+        {
+            hits.add();
+            return true;
+        }
+        misses.add();
+    }
+    auto result = [&]() {
+        SWD_PROFILE_SCOPE("CompileShader::compile");
+        return compiler.CompileGlslToSpv(source, kind, name, options);
+    }();
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+    {
+        std::cerr << "CompileShader::execute: failed to compile. Error message: " << result.GetErrorMessage() << '\n';
+        return false;
     }
+    code.assign(result.cbegin(), result.cend());
+    if (cached)
+        util::spirvCache().store(key, code.data(), code.size());
+    return true;
 }
 
 void CompileShader::set(const std::string_view rel_path, const std::string_view name, state::ShaderReport* report)
@@ -55,6 +135,7 @@ void CompileShader::set(const std::string_view rel_path, const std::string_view
 
 void CompileShader::execute(Application* app)
 {
+    SWD_PROFILE_SCOPE("CompileShader::execute");
     std::ifstream f;
     std::stringstream ss;
     std::cout << "SRC PATH: " << src_path << '\n';
@@ -66,23 +147,24 @@ void CompileShader::execute(Application* app)
         std::cerr << "file not open" << '\n';
         return;
     }
-    auto result = compiler.CompileGlslToSpv(ss.str(), kind, name.c_str(), compileOptions);
-    if (result.GetCompilationStatus() == 0)
-    {
-        std::vector<uint32_t> code;
-        for (const auto& i : result) 
-        {
-            code.push_back(i);
-        }
-        switch (type)
-        {
-            case ShaderType::frag: app->renderer.loadFragShader(std::move(code), name); success(); break;
-            case ShaderType::vert: app->renderer.loadVertShader(std::move(code), name); success(); break;
-        }
-    }
-    else
+    // a fresh includer each time, so it holds just this compile's includes
+    auto includer = std::make_unique<SourceIncluder>();
+    const auto& includes = includer->getIncluded();
+    compileOptions.SetIncluder(std::move(includer));
+    std::vector<uint32_t> code;
+    bool compiled = compileCached(ss.str(), kind, name.c_str(), compileOptions, code);
+    // recorded and watched even if the compile failed, so fixing an include reloads it
+    includeGraph().record(src_path.string(), includes);
+    app->dispatcher.fileWatcher.addWatch(src_path.c_str());
+    for (const auto& include : includes) 
+        app->dispatcher.fileWatcher.addWatch(include.c_str());
+    if (!compiled)
+        return;
+    SWD_PROFILE_SCOPE("CompileShader::load");
+    switch (type)
     {
-        std::cerr << "CompileShader::execute: failed to compile. Error message: " << result.GetErrorMessage() << '\n';
+        case ShaderType::frag: app->renderer.loadFragShader(std::move(code), name); success(); break;
+        case ShaderType::vert: app->renderer.loadVertShader(std::move(code), name); success(); break;
     }
 }
 
@@ -94,26 +176,21 @@ state::Report* CompileShader::makeReport() const
         return report;
 }
 
+std::optional<render::Dependencies> CompileShader::getDependencies() const
+{
+    return render::Dependencies{{}, {(type == ShaderType::frag ? "frag:" : "vert:") + name}};
+}
+
 void CompileShaderCode::execute(Application* app)
 {
     auto kind = (type == ShaderType::frag ? shaderc_shader_kind::shaderc_glsl_fragment_shader : shaderc_shader_kind::shaderc_glsl_vertex_shader);
-    auto result = compiler.CompileGlslToSpv(glslCode, kind, name.c_str());
-    if (result.GetCompilationStatus() == 0)
-    {
-        std::vector<uint32_t> spvCode;
-        for (const auto& i : result) 
-        {
-            spvCode.push_back(i);
-        }
-        switch (type)
-        {
-            case ShaderType::frag: app->renderer.loadFragShader(std::move(spvCode), name); success(); break;
-            case ShaderType::vert: app->renderer.loadVertShader(std::move(spvCode), name); success(); break;
-        }
-    }
-    else
+    std::vector<uint32_t> spvCode;
+    if (!compileCached(glslCode, kind, name.c_str(), shaderc::CompileOptions{}, spvCode))
+        return;
+    switch (type)
     {
-        std::cerr << "CompileShader::execute: failed to compile. Error message: " << result.GetErrorMessage() << '\n';
+        case ShaderType::frag: app->renderer.loadFragShader(std::move(spvCode), name); success(); break;
+        case ShaderType::vert: app->renderer.loadVertShader(std::move(spvCode), name); success(); break;
     }
 }
 
@@ -125,6 +202,11 @@ state::Report* CompileShaderCode::makeReport() const
         return report;
 }
 
+std::optional<render::Dependencies> CompileShaderCode::getDependencies() const
+{
+    return render::Dependencies{{}, {(type == ShaderType::frag ? "frag:" : "vert:") + name}};
+}
+
 }; // namespace command
 
 }; // namespace sword
@@ -0,0 +1,158 @@
+#include "shadersources.hpp"
+#include <util/defs.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace sword
+{
+
+namespace command
+{
+
+ShaderSources::ShaderSources(std::filesystem::path root) :
+    root{root.lexically_normal()}
+{}
+
+bool ShaderSources::ignored(const std::filesystem::path& path)
+{
+    auto name = path.filename().string();
+    return name.empty() || name.front() == '.' || name.back() == '~';
+}
+
+// one name per directory between the file and the root, the root itself excluded
+void ShaderSources::add(Index& index, const std::filesystem::path& file) const
+{
+    auto full = file.lexically_normal();
+    if (ignored(full) || !index.files.insert(full.string()).second)
+        return;
+    for (auto dir = full.parent_path(); dir != root && dir.has_relative_path() && dir != dir.parent_path(); dir = dir.parent_path())
+    {
+        auto& candidates = index.byName[full.lexically_relative(dir).string()];
+        candidates.insert(std::lower_bound(candidates.begin(), candidates.end(), full.string()), full.string());
+    }
+}
+
+void ShaderSources::remove(Index& index, const std::string& file) const
+{
+    if (!index.files.erase(file))
+        return;
+    std::filesystem::path full{file};
+    for (auto dir = full.parent_path(); dir != root && dir.has_relative_path() && dir != dir.parent_path(); dir = dir.parent_path())
+    {
+        auto it = index.byName.find(full.lexically_relative(dir).string());
+        if (it == index.byName.end()) continue;
+        auto& candidates = it->second;
+        candidates.erase(std::remove(candidates.begin(), candidates.end(), file), candidates.end());
+        if (candidates.empty())
+            index.byName.erase(it);
+    }
+}
+
+std::shared_ptr<const ShaderSources::Index> ShaderSources::snapshot() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!index)
+    {
+        auto built = std::make_shared<Index>();
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(root, ec)) 
+            if (entry.is_regular_file())
+                add(*built, entry.path());
+        index = std::move(built);
+    }
+    return index;
+}
+
+void ShaderSources::update(const std::string& path, bool added, bool isDir)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!index)
+        return; //the first lookup will see it
+    auto next = std::make_shared<Index>(*index);
+    auto full = std::filesystem::path(path).lexically_normal();
+    if (isDir && added)
+    {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(full, ec)) 
+            if (entry.is_regular_file())
+                add(*next, entry.path());
+    }
+    else if (isDir)
+    {
+        auto prefix = full.string() + '/';
+        std::vector<std::string> gone;
+        for (const auto& file : next->files) 
+            if (file.compare(0, prefix.size(), prefix) == 0)
+                gone.push_back(file);
+        for (const auto& file : gone) 
+            remove(*next, file);
+    }
+    else if (added)
+        add(*next, full);
+    else
+        remove(*next, full.string());
+    index = std::move(next);
+}
+
+void ShaderSources::invalidate()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    index.reset();
+}
+
+std::string ShaderSources::find(std::string_view requested, std::string_view requesting) const
+{
+    auto current = snapshot();
+    if (!requesting.empty())
+    {
+        auto beside = (std::filesystem::path(requesting).parent_path() / requested).lexically_normal().string();
+        if (current->files.count(beside))
+            return beside;
+    }
+    auto it = current->byName.find(std::filesystem::path(requested).lexically_normal().string());
+    if (it == current->byName.end())
+        return {};
+    return it->second.front();
+}
+
+ShaderSources& shaderSources()
+{
+    static ShaderSources sources{SHADER_SRC};
+    return sources;
+}
+
+shaderc_include_result* SourceIncluder::GetInclude(const char* requested, shaderc_include_type type,
+        const char* requesting, size_t depth)
+{
+    auto result = new Result;
+    result->path = shaderSources().find(requested, type == shaderc_include_type_relative ? requesting : "");
+    std::ifstream f;
+    if (!result->path.empty())
+        f.open(result->path);
+    if (f.is_open())
+    {
+        std::stringstream ss;
+        ss << f.rdbuf();
+        result->content = ss.str();
+        if (std::find(included.begin(), included.end(), result->path) == included.end())
+            included.push_back(result->path);
+    }
+    else
+    {
+        result->path.clear();
+        result->content = std::string("Cannot find or open include file: ") + requested;
+    }
+    result->result = {result->path.c_str(), result->path.size(), 
+        result->content.c_str(), result->content.size(), result};
+    return &result->result;
+}
+
+void SourceIncluder::ReleaseInclude(shaderc_include_result* result)
+{
+    delete static_cast<Result*>(result->user_data);
+}
+
+}; // namespace command
+
+}; // namespace sword
@@ -0,0 +1,80 @@
+#ifndef COMMAND_SHADERSOURCES_HPP
+#define COMMAND_SHADERSOURCES_HPP
+
+//imp: command/shadersources.cpp
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shaderc/shaderc.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace sword
+{
+
+namespace command
+{
+
+// every file under the shader source tree, by each path an include could name
+// it with: "stroke.glsl" from its own directory, "fragment/stroke.glsl" from
+// the one above and so on. this is the same set of places the old per-compile
+// FileFinder probed, one directory at a time, but resolved with a single hash
+// lookup. built on first use. after that it follows the tree's inotify events
+// instead of rescanning: each change makes a new index, and lookups keep
+// whichever one they started with. if events were lost it is dropped, and the
+// next lookup scans again
+class ShaderSources
+{
+public:
+    explicit ShaderSources(std::filesystem::path root);
+    // the full path an include resolves to, or empty. a relative include looks
+    // beside the file asking for it first, as the compiler would
+    std::string find(std::string_view requested, std::string_view requesting = {}) const;
+    void update(const std::string& path, bool added, bool isDir); //from the file watcher thread
+    void invalidate();
+private:
+    struct Index
+    {
+        std::unordered_map<std::string, std::vector<std::string>> byName; //candidates, in order, first wins
+        std::unordered_set<std::string> files;
+    };
+    std::shared_ptr<const Index> snapshot() const;
+    void add(Index&, const std::filesystem::path& file) const;
+    void remove(Index&, const std::string& file) const;
+    static bool ignored(const std::filesystem::path&); //editor swap and backup files
+
+    const std::filesystem::path root;
+    mutable std::mutex lock;
+    mutable std::shared_ptr<const Index> index;
+};
+
+ShaderSources& shaderSources(); //the one under SHADER_SRC
+
+// resolves includes through shaderSources and remembers what it resolved,
+// so a compile knows its include set afterwards
+class SourceIncluder : public shaderc::CompileOptions::IncluderInterface
+{
+public:
+    shaderc_include_result* GetInclude(const char* requested, shaderc_include_type type,
+            const char* requesting, size_t depth) override;
+    void ReleaseInclude(shaderc_include_result*) override;
+    const std::vector<std::string>& getIncluded() const { return included; }
+private:
+    struct Result
+    {
+        shaderc_include_result result;
+        std::string path;
+        std::string content;
+    };
+    std::vector<std::string> included;
+};
+
+}; // namespace command
+
+}; // namespace sword
+
+#endif /* end of include guard: COMMAND_SHADERSOURCES_HPP */
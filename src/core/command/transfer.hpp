@@ -36,6 +36,7 @@ class CopyImageToAttachment : public Command
 public:
     void execute(Application*) override;
     const char* getName() const override {return "CopyImageToAttachment";};
+    bool changesFrame() const override { return true; }
     void set(render::Image* image, std::string attachmentName, vk::Rect2D region) 
     {
         this->attachmentName = attachmentName;
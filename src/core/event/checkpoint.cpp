@@ -0,0 +1,141 @@
+#include "checkpoint.hpp"
+#include <util/debug.hpp>
+#include <algorithm>
+#include <iostream>
+#include <lodepng.h>
+
+namespace sword
+{
+
+namespace event
+{
+
+using namespace logformat;
+
+bool CheckpointWriter::open(const std::string& path)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (os.is_open())
+        os.close();
+    os.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    return os.is_open();
+}
+
+void CheckpointWriter::close()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    os.close();
+}
+
+bool CheckpointWriter::write(const Checkpoint& checkpoint)
+{
+    std::vector<unsigned char> compressed;
+    if (!checkpoint.pixels.empty())
+    {
+        auto error = lodepng::compress(compressed, checkpoint.pixels.data(), checkpoint.pixels.size());
+        if (error)
+        {
+            std::cerr << "CheckpointWriter::write: " << lodepng_error_text(error) << '\n';
+            return false;
+        }
+    }
+    CheckpointHeader header{};
+    std::memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+    header.event = checkpoint.event;
+    header.time = checkpoint.time;
+    header.stateSize = checkpoint.state.size();
+    header.nameSize = checkpoint.attachment.size();
+    header.width = checkpoint.width;
+    header.height = checkpoint.height;
+    header.pixelSize = compressed.size();
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (!os.is_open())
+        return false;
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(checkpoint.state.data()), checkpoint.state.size());
+    os.write(checkpoint.attachment.data(), checkpoint.attachment.size());
+    os.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+    os.flush();
+    SWD_DEBUG_MSG("checkpoint at event " << checkpoint.event << ", " << compressed.size() << " bytes of pixels");
+    return os.good();
+}
+
+bool CheckpointReader::open(const std::string& path)
+{
+    entries.clear();
+    is.close();
+    is.open(path, std::ios::in | std::ios::binary);
+    if (!is.is_open())
+        return false;
+    is.seekg(0, std::ios::end);
+    uint64_t size = is.tellg();
+    uint64_t offset = 0;
+    CheckpointHeader header;
+    while (offset + sizeof(header) <= size)
+    {
+        is.seekg(offset);
+        is.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!is || std::memcmp(header.magic, checkpointMagic, sizeof(checkpointMagic)) != 0)
+            break;
+        uint64_t end = offset + sizeof(header) + header.stateSize + header.nameSize + header.pixelSize;
+        if (end > size)
+            break;
+        if (!entries.empty() && header.event < entries.back().event)
+            break;
+        entries.push_back({header.event, header.time, offset});
+        offset = end;
+    }
+    is.clear();
+    return true;
+}
+
+const CheckpointReader::Entry* CheckpointReader::nearest(uint64_t event) const
+{
+    auto after = std::upper_bound(entries.begin(), entries.end(), event,
+            [](uint64_t e, const Entry& entry) { return e < entry.event; });
+    if (after == entries.begin())
+        return nullptr;
+    return &*(after - 1);
+}
+
+bool CheckpointReader::load(const Entry& entry, Checkpoint& checkpoint)
+{
+    CheckpointHeader header;
+    is.seekg(entry.offset);
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    checkpoint = Checkpoint{};
+    checkpoint.event = header.event;
+    checkpoint.time = header.time;
+    checkpoint.width = header.width;
+    checkpoint.height = header.height;
+    checkpoint.state.resize(header.stateSize);
+    checkpoint.attachment.resize(header.nameSize);
+    std::vector<unsigned char> compressed(header.pixelSize);
+    is.read(reinterpret_cast<char*>(checkpoint.state.data()), header.stateSize);
+    is.read(checkpoint.attachment.data(), header.nameSize);
+    is.read(reinterpret_cast<char*>(compressed.data()), header.pixelSize);
+    if (!is)
+    {
+        is.clear();
+        return false;
+    }
+    if (compressed.empty())
+        return true;
+    auto error = lodepng::decompress(checkpoint.pixels, compressed);
+    if (error)
+    {
+        std::cerr << "CheckpointReader::load: " << lodepng_error_text(error) << '\n';
+        return false;
+    }
+    if (checkpoint.pixels.size() != size_t(header.width) * header.height * 4)
+    {
+        std::cerr << "CheckpointReader::load: canvas at event " << header.event << " has the wrong size" << '\n';
+        return false;
+    }
+    return true;
+}
+
+}; // namespace event
+
+}; // namespace sword
@@ -0,0 +1,116 @@
+#ifndef EVENT_CHECKPOINT_HPP
+#define EVENT_CHECKPOINT_HPP
+
+//imp: event/checkpoint.cpp
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sword
+{
+
+namespace event
+{
+
+// checkpoints live next to their event log, in <log>.ckpt, one after another:
+//   CheckpointHeader
+//   state bytes           whatever the states put in, in stack order
+//   attachment name
+//   pixels                rgba8, zlib compressed
+// a checkpoint cut short at the end of the file is ignored
+namespace logformat
+{
+
+constexpr char checkpointMagic[8] = {'S', 'W', 'D', 'C', 'K', 'P', 'T', '1'};
+
+struct CheckpointHeader
+{
+    char magic[8];
+    uint64_t event; //events in the log before the checkpoint was taken
+    uint64_t time;  //log time of the last of those
+    uint32_t stateSize;
+    uint32_t nameSize;
+    uint32_t width;
+    uint32_t height;
+    uint64_t pixelSize;
+};
+
+static_assert(sizeof(CheckpointHeader) == 48);
+
+}; // namespace logformat
+
+// what the session looked like after some number of events. the renderer's
+// objects aren't in here: a seek rebuilds them by replaying the events that
+// create them, then puts the canvas and the states' variables back from this
+struct Checkpoint
+{
+    uint64_t event{0};
+    uint64_t time{0};
+    std::vector<uint8_t> state;
+    std::string attachment; //the one attachment worth keeping. empty if there is none
+    uint32_t width{0};
+    uint32_t height{0};
+    std::vector<uint8_t> pixels;
+    size_t cursor{0}; //read position in state
+
+    template <typename T>
+    void put(const T& value)
+    {
+        auto bytes = reinterpret_cast<const uint8_t*>(&value);
+        state.insert(state.end(), bytes, bytes + sizeof(T));
+    }
+
+    // false, leaving value alone, if the bytes ran out
+    template <typename T>
+    bool take(T& value)
+    {
+        if (cursor + sizeof(T) > state.size())
+            return false;
+        std::memcpy(&value, state.data() + cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+};
+
+// write may be called from any thread, one checkpoint at a time is written
+class CheckpointWriter
+{
+public:
+    bool open(const std::string& path); //truncates
+    bool isOpen() const { return os.is_open(); }
+    void close();
+    bool write(const Checkpoint&); //compresses the pixels first, so it takes a while
+private:
+    std::ofstream os;
+    std::mutex lock;
+};
+
+class CheckpointReader
+{
+public:
+    struct Entry
+    {
+        uint64_t event;
+        uint64_t time;
+        uint64_t offset;
+    };
+
+    bool open(const std::string& path); //reads the headers only
+    // the last checkpoint at or before event, or null if there is none
+    const Entry* nearest(uint64_t event) const;
+    bool load(const Entry&, Checkpoint&);
+    size_t size() const { return entries.size(); }
+private:
+    std::ifstream is;
+    std::vector<Entry> entries;
+};
+
+}; // namespace event
+
+}; // namespace sword
+
+#endif /* end of include guard: EVENT_CHECKPOINT_HPP */
@@ -6,6 +6,7 @@
 #include <thread>
 #include <util/outformat.hpp>
 #include <util/debug.hpp>
+#include <util/profiler.hpp>
 
 namespace sword
 {
@@ -36,6 +37,11 @@ EventDispatcher::EventDispatcher(const render::Window& window):
     std::cout << "event dispatcher ctor called" << std::endl;
     rl_attempted_completion_function = completer;
     rl_bind_key(27, abortHelper);
+
+    auto& reg = util::metrics::registry();
+    watches.push_back(reg.watch("queue.event.depth", [this]() { return int64_t(eventQueue.size()); }));
+    watches.push_back(reg.watch("queue.event.highWater", [this]() { return int64_t(eventQueue.highWaterMark()); }));
+    watches.push_back(reg.watch("queue.event.dropped", [this]() { return int64_t(eventQueue.dropped()); }));
 }
 
 EventDispatcher::~EventDispatcher()
@@ -51,17 +57,8 @@ char* EventDispatcher::completion_generator(const char* text, int state)
 
     if (state == 0)
     {
-        matches.clear();
+        matches = vocabIndex.complete(text);
         match_index = 0;
-    
-        std::string textstr(text);
-        for (auto word : vocabulary)
-        {
-            if (word.size() >= textstr.size() && word.compare(0, textstr.size(), textstr) == 0)
-            {
-                matches.push_back(word);
-            }
-        }
     }
     
     if (match_index >= matches.size())
@@ -83,30 +80,22 @@ char** EventDispatcher::completer(const char* text, int start, int end)
 
 void EventDispatcher::setVocabulary(std::vector<std::string> vocab)
 {
-    vocabulary = vocab;
+    vocabIndex.replace(std::move(vocab));
 }
 
 void EventDispatcher::updateVocab()
 {
-    vocabulary.clear();
-    for (const auto& vptr : vocabPtrs) 
-    {
-        auto words = vptr->getWords();
-        for (const auto& word : words) 
-            vocabulary.push_back(word);   
-    }
+    vocabIndex.refresh();
 }
 
 void EventDispatcher::addVocab(const state::Vocab* vptr)
 {
-    vocabPtrs.push_back(vptr);
-    updateVocab();
+    vocabIndex.push(vptr);
 }
 
 void EventDispatcher::popVocab()
 {
-    vocabPtrs.pop_back();
-    updateVocab();
+    vocabIndex.pop();
 }
 
 void EventDispatcher::fetchCommandLineInput()
@@ -135,48 +124,67 @@ void EventDispatcher::fetchCommandLineInput()
     {
         if (catcher == "q")
         {
-            Vessel event = aPool.request();
-            eventQueue.push(std::move(event));
+            eventQueue.push(Any::make<Abort>());
             std::cout << "Aborting operation" << std::endl;
             std::this_thread::sleep_for(std::chrono::milliseconds(RL_DELAY));
             return;
         }
     }
 
-    auto event = clPool.request(input);
-    lock.lock();
-    eventQueue.push(std::move(event));
-    lock.unlock();
+    Any event;
+    if (!event.emplace<CommandLine>().set(input))
+        std::cerr << "Input is longer than " << CommandLine::maxInput << " characters or " << CommandLine::maxWords << " words, the rest is cut off" << '\n';
+    if (!eventQueue.push(std::move(event)))
+        std::cerr << "Event queue is full. Dropped: " << input << '\n';
 
     std::this_thread::sleep_for(std::chrono::milliseconds(RL_DELAY));
 }
 
-void EventDispatcher::fetchWindowInput()
-{	
-    auto* event = window.waitForEvent();
-    assert (event);
-    Vessel curEvent;
+// x stamps its events in milliseconds on its own clock. we map that onto ours
+// with the smallest gap seen so far between an event's stamp and when we read
+// it, the closest we can get to a delivery with no delay. a gap that suddenly
+// grows by more than resync means the server clock restarted or wrapped
+std::chrono::steady_clock::time_point EventDispatcher::fromServerTime(xcb_timestamp_t time)
+{
+    constexpr auto resync = std::chrono::seconds(10);
+    auto server = std::chrono::milliseconds(time);
+    auto gap = std::chrono::steady_clock::now().time_since_epoch() - server;
+    if (!serverClockKnown || gap < serverClockOffset || gap - serverClockOffset > resync)
+    {
+        serverClockOffset = gap;
+        serverClockKnown = true;
+    }
+    return std::chrono::steady_clock::time_point(server + serverClockOffset);
+}
+
+Any EventDispatcher::translateWindowEvent(xcb_generic_event_t* event)
+{
+    Any curEvent;
+    xcb_timestamp_t serverTime{XCB_CURRENT_TIME};
 	switch (static_cast<WindowEventType>(event->response_type))
 	{
         case WindowEventType::Motion: 
 		{
 			xcb_motion_notify_event_t* motion =
 				(xcb_motion_notify_event_t*)event;
-            curEvent = mmPool.request(motion->event_x, motion->event_y);
+            curEvent = Any::make<MouseMotion>(motion->event_x, motion->event_y);
+            serverTime = motion->time;
             break;
 		}
         case WindowEventType::MousePress:
 		{
             xcb_button_press_event_t* press = 
                 (xcb_button_press_event_t*)event;
-            curEvent = mpPool.request(press->event_x, press->event_y, static_cast<symbol::MouseButton>(press->detail));
+            curEvent = Any::make<MousePress>(press->event_x, press->event_y, static_cast<symbol::MouseButton>(press->detail));
+            serverTime = press->time;
             break;
 		}
         case WindowEventType::MouseRelease:
 		{
             xcb_button_press_event_t* press = 
                 (xcb_button_press_event_t*)event;
-            curEvent = mrPool.request(press->event_x, press->event_y, static_cast<symbol::MouseButton>(press->detail));
+            curEvent = Any::make<MouseRelease>(press->event_x, press->event_y, static_cast<symbol::MouseButton>(press->detail));
+            serverTime = press->time;
             break;
 		}
         case WindowEventType::Keypress:
@@ -186,14 +194,16 @@ void EventDispatcher::fetchWindowInput()
             //will cause this to be the last iteration of the window loop
             if (static_cast<symbol::Key>(keyPress->detail) == symbol::Key::Esc)
                 keepWindowThread = false;
-            curEvent = kpPool.request(keyPress->event_x, keyPress->event_y, static_cast<symbol::Key>(keyPress->detail));
+            curEvent = Any::make<KeyPress>(keyPress->event_x, keyPress->event_y, static_cast<symbol::Key>(keyPress->detail));
+            serverTime = keyPress->time;
             break;
 		}
         case WindowEventType::Keyrelease:
         {
             xcb_key_release_event_t* keyRelease = 
                 (xcb_key_release_event_t*)event;
-            curEvent = krPool.request(keyRelease->event_x, keyRelease->event_y, static_cast<symbol::Key>(keyRelease->detail));
+            curEvent = Any::make<KeyRelease>(keyRelease->event_x, keyRelease->event_y, static_cast<symbol::Key>(keyRelease->detail));
+            serverTime = keyRelease->time;
             break;
         }
         case WindowEventType::EnterWindow:
@@ -204,12 +214,57 @@ void EventDispatcher::fetchWindowInput()
         case WindowEventType::LeaveWindow:
         {
             xcb_leave_notify_event_t* leaveEvent = (xcb_leave_notify_event_t*)event;
-            curEvent = lwPool.request();
+            curEvent = Any::make<LeaveWindow>();
+            serverTime = leaveEvent->time;
             break;
         }
 	}
-	free(event);
-    eventQueue.push(std::move(curEvent));
+    //readline and inotify input keeps the stamp it got when it was constructed, which is as soon as we have it
+    if (curEvent && serverTime != XCB_CURRENT_TIME)
+        curEvent->setCreationTime(fromServerTime(serverTime));
+    return curEvent;
+}
+
+// waits for one event, then takes whatever else the server has already sent
+// without waiting again. the lot goes into the queue in one push, with each run
+// of motion already folded into as few events as hold it unthinned, so a fast
+// mouse costs the queue one reservation per wakeup instead of one per report
+void EventDispatcher::fetchWindowInput()
+{	
+    auto* event = window.waitForEvent();
+    assert (event);
+    SWD_PROFILE_SCOPE("EventDispatcher::fetchWindowInput"); // not counting the wait
+    size_t batched = 0;
+    size_t drained = 0;
+    while (event)
+    {
+        Any curEvent = translateWindowEvent(event);
+        free(event);
+        if (curEvent)
+        {
+            auto motion = curEvent.getIf<MouseMotion>();
+            auto previous = batched ? windowBatch[batched - 1].getIf<MouseMotion>() : nullptr;
+            if (motion && previous && previous->hasRoomFor(*motion))
+                previous->append(*motion);
+            else
+            {
+                if (batched == windowBatch.size())
+                {
+                    publishWindowBatch(batched);
+                    batched = 0;
+                }
+                windowBatch[batched++] = std::move(curEvent);
+            }
+        }
+        //a steady drag would otherwise keep us merging motion and never publishing
+        event = ++drained < maxDrain ? window.pollEvents() : nullptr;
+    }
+    publishWindowBatch(batched);
+}
+
+void EventDispatcher::publishWindowBatch(size_t count)
+{
+    eventQueue.pushBatch(windowBatch.data(), count); //drops are counted by the queue and reported by the app
 }
 
 void EventDispatcher::runCommandLineLoop()
@@ -236,68 +291,65 @@ void EventDispatcher::pollEvents()
 {
     std::thread t0(&EventDispatcher::runCommandLineLoop, this);
     std::thread t1(&EventDispatcher::runWindowInputLoop, this);
-    std::thread t2(&FileWatcher::run, &fileWatcher);
     t0.detach();
     t1.detach();
-    t2.detach();
+    fileWatcher.start();
 }
 
-static int clCount = 0;
-
-void EventDispatcher::readEvents(std::ifstream& is, int eventPops)
+void EventDispatcher::readEvents(LogReader& log, int eventPops)
 {
-    bool reading{true};
-    while (is.peek() != EOF)
-    {
-        Category ec = Event::unserializeCategory(is);
-        if (ec == Category::CommandLine)
-        {
-            auto event = clPool.request("foo");
-            auto cmdevent = static_cast<CommandLine*>(event.get());
-            cmdevent->unserialize(is);
-            eventQueue.push(std::move(event));
-            clCount++;
-            std::cout << "pushed commandline event" << std::endl;
-            std::cout << "Cl count: " << clCount << std::endl;
-            std::cout << "Cl content: " << cmdevent->getInput() << '\n';
-        }
-        if (ec == Category::Abort)
-        {
-            auto abrt = aPool.request();
-            eventQueue.push(std::move(abrt));
-            std::cout << "pushed abort event" << std::endl;
-        }
-    }
+    LogRecord record;
+    while (log.next(record))
+        replay(record);
     for (int i = 0; i < eventPops; i++) 
     {
         eventQueue.pop();
-        std::cout << "popped from queue" << std::endl;
+        SWD_DEBUG_MSG("popped from queue");
     }
 }
 
-void EventDispatcher::readEvent(std::ifstream& is)
+// false once the log runs out
+bool EventDispatcher::readEvent(LogReader& log)
+{
+    LogRecord record;
+    if (!log.next(record))
+        return false;
+    replay(record);
+    return true;
+}
+
+void EventDispatcher::replay(const LogRecord& record)
 {
-    if (is.peek() != EOF)
+    Any event;
+    switch (record.category)
     {
-        Category ec = Event::unserializeCategory(is);
-        if (ec == Category::CommandLine)
-        {
-            auto event = clPool.request("foo");
-            auto cmdevent = static_cast<CommandLine*>(event.get());
-            cmdevent->unserialize(is);
-            eventQueue.push(std::move(event));
-            clCount++;
-            std::cout << "pushed commandline event" << std::endl;
-            std::cout << "Cl count: " << clCount << std::endl;
-            std::cout << "Cl content: " << cmdevent->getInput() << '\n';
-        }
-        if (ec == Category::Abort)
+        case Category::CommandLine: event = Any::make<CommandLine>(record.text); break;
+        case Category::Abort: event = Any::make<Abort>(); break;
+        case Category::Window:
         {
-            auto abrt = aPool.request();
-            eventQueue.push(std::move(abrt));
-            std::cout << "pushed abort event" << std::endl;
+            switch (record.windowType)
+            {
+                case WindowEventType::Motion: event = Any::make<MouseMotion>(record.x, record.y); break;
+                case WindowEventType::MousePress: 
+                    event = Any::make<MousePress>(record.x, record.y, static_cast<symbol::MouseButton>(record.detail)); break;
+                case WindowEventType::MouseRelease: 
+                    event = Any::make<MouseRelease>(record.x, record.y, static_cast<symbol::MouseButton>(record.detail)); break;
+                case WindowEventType::Keypress: 
+                    event = Any::make<KeyPress>(record.x, record.y, static_cast<symbol::Key>(record.detail)); break;
+                case WindowEventType::Keyrelease: 
+                    event = Any::make<KeyRelease>(record.x, record.y, static_cast<symbol::Key>(record.detail)); break;
+                case WindowEventType::LeaveWindow: event = Any::make<LeaveWindow>(); break;
+                default: break;
+            }
+            break;
         }
+        default: break;
     }
+    if (!event)
+        return;
+    SWD_TRACE_MSG("replaying " << event->getName());
+    if (!eventQueue.push(std::move(event)))
+        std::cerr << "Event queue is full. Dropped a replayed event." << '\n';
 }
 
 
@@ -3,8 +3,11 @@
 
 #include "event.hpp"
 #include "types.hpp"
+#include "queue.hpp"
 #include "filewatcher.hpp"
-#include <mutex>
+#include "vocabindex.hpp"
+#include "eventlog.hpp"
+#include <util/metrics.hpp>
 
 namespace sword
 {
@@ -12,7 +15,7 @@ namespace sword
 namespace event
 {
 
-//this class is not thread safe at all
+//this class is not thread safe at all, apart from the eventQueue, which any thread may push to
 class EventDispatcher
 {
 public:
@@ -30,11 +33,44 @@ public:
 
     void runCommandLineLoop();
     void runWindowInputLoop();
-    void readEvents(std::ifstream& is, int eventPops);
-    void readEvent(std::ifstream& is);
+    void readEvents(LogReader&, int eventPops);
+    bool readEvent(LogReader&);
+    void replay(const LogRecord&);
 
     void getNextEvent();
 
+    // hands every queued event to handle, in order, except that each run of
+    // motion events comes out as one, merged into the first of the run. so 
+    // however fast the mouse reports, the states see a bounded amount of motion
+    // per frame. record sees each event as it was queued, before any merging, so
+    // what it sees doesn't depend on how the frames fell.
+    // main thread only, like eventQueue.popAll
+    template <typename F, typename R>
+    void drainEvents(F&& handle, R&& record)
+    {
+        Any motion;
+        eventQueue.popAll([&](Any&& event)
+        {
+            record(*event.get());
+            if (auto later = event.getIf<MouseMotion>())
+            {
+                if (!motion)
+                    motion = std::move(event);
+                else
+                    motion.getIf<MouseMotion>()->append(*later);
+                return;
+            }
+            if (motion)
+            {
+                handle(std::move(motion));
+                motion = Any();
+            }
+            handle(std::move(event));
+        });
+        if (motion)
+            handle(std::move(motion));
+    }
+
     WindowInput windowInput;
     std::string commandLineInput;
     inline void setInputMode(InputMode mode) {inputMode = mode;}
@@ -42,28 +78,28 @@ public:
     EventQueue eventQueue;
     FileWatcher fileWatcher;
 
-    std::mutex lock;
-
 private:
     const render::Window& window;
     InputMode inputMode{InputMode::CommandLine};
 
-    inline static std::vector<std::string> vocabulary{};
-    inline static std::vector<const state::Vocab*> vocabPtrs;
+    inline static VocabIndex vocabIndex;
     static char* completion_generator(const char* text, int state);
     static char** completer(const char* text, int start, int end);
+    Any translateWindowEvent(xcb_generic_event_t*);
+    std::chrono::steady_clock::time_point fromServerTime(xcb_timestamp_t);
+    void publishWindowBatch(size_t count);
     bool keepWindowThread{true};
     bool keepCommandThread{true};
 
-    //pools
-    Pool<CommandLine, 200> clPool;
-    Pool<KeyPress, 50> kpPool;
-    Pool<KeyRelease, 20> krPool;
-    Pool<MousePress, 20> mpPool;
-    Pool<MouseRelease, 20> mrPool;
-    Pool<MouseMotion, 100> mmPool;
-    Pool<Abort, 50> aPool;
-    Pool<LeaveWindow, 3> lwPool;
+    // window events read in one wakeup, waiting to go into the queue together
+    static constexpr size_t maxDrain = 256;
+    std::array<Any, 32> windowBatch;
+
+    // x server time to steady_clock, see fromServerTime
+    std::chrono::steady_clock::duration serverClockOffset{0};
+    bool serverClockKnown{false};
+
+    std::vector<util::metrics::Watch> watches;
 };
 
 }; // namespace event
@@ -6,6 +6,15 @@
 #include <queue>
 #include <fstream>
 #include <sstream>
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+#include <charconv>
+#include <cctype>
+#include <ostream>
+#include <type_traits>
+#include <vector>
 
 namespace sword
 {
@@ -71,122 +80,215 @@ enum class Category : uint8_t
     EndFrame
 };
 
+// which events a state is offered: a category, and for window events
+// optionally a type and a key or button within it
+struct Route
+{
+    static constexpr uint8_t any = 0xff;
+    constexpr Route(Category category) : category{category} {}
+    constexpr Route(WindowEventType type) : 
+        category{Category::Window}, type{static_cast<uint8_t>(type)} {}
+    constexpr Route(WindowEventType type, symbol::Key key) : 
+        category{Category::Window}, type{static_cast<uint8_t>(type)}, detail{static_cast<uint8_t>(key)} {}
+    constexpr Route(WindowEventType type, symbol::MouseButton button) : 
+        category{Category::Window}, type{static_cast<uint8_t>(type)}, detail{static_cast<uint8_t>(button)} {}
+    Category category;
+    uint8_t type{any};
+    uint8_t detail{any};
+};
+
+using Routes = std::vector<Route>;
+
+// events are values, held in an event::Any (event/types.hpp) from the thread
+// that reads the input until the frame that handles it. they are stamped when
+// they are made
 class Event
 {
 public:
     virtual ~Event() = default;
     virtual Category getCategory() const = 0;
-    virtual std::string getName() const = 0;
+    virtual const char* getName() const = 0;
     template <typename... Args> void set(Args... args) {}
-    bool isAvailable() const {return !inUse;}
     void setHandled() {handled = true;}
     bool isHandled() const {return handled;}
-    static Category unserializeCategory(std::ifstream& is)
-    {
-        Category ec;
-        is.read((char*)&ec, sizeof(Category));
-        if (ec == Category::CommandLine)
-            return Category::CommandLine;
-        else if (ec == Category::Abort)
-            return Category::Abort;
-        else
-        {
-            throw std::runtime_error("Could not unserialize category");
-        }
-    }
-    void reset() {inUse = false; handled = false;}
-    void activate() {inUse = true;}
+    std::chrono::steady_clock::time_point getCreationTime() const {return created;}
+    // for sources that know when the input happened better than when we got to it
+    virtual void setCreationTime(std::chrono::steady_clock::time_point time) {created = time;}
 protected:
     bool handled{false};
-    bool inUse{false};
+    std::chrono::steady_clock::time_point created{std::chrono::steady_clock::now()};
 };
 
 class File : public Event
 {
 public:
     Category getCategory() const override { return Category::File; }
-    std::string getName() const override { return "File"; }
-    void set(int wd, std::string path) { this->wd = wd; this->path = path; }
+    const char* getName() const override { return "File"; }
+    void set(int wd, const char* path) { this->wd = wd; this->path = path; } //path must outlive the event
     std::string getPath() const { return path; }
     int getWd() const { return wd; }
 private:
     int wd;
-    std::string path;
+    const char* path;
 };
 
 class Abort : public Event
 {
 public:
    Category getCategory() const override {return Category::Abort;} 
-   std::string getName() const override {return "Abort";}
+   const char* getName() const override {return "Abort";}
    void set() {}
-   void serialize(std::ofstream& os) 
-   {
-       auto cat = getCategory();
-       os.write((char*)&cat, sizeof(Category));
-   }
 };
 
 class Nothing : public Event
 {
 public:
    Category getCategory() const override {return Category::Nothing;} 
-   std::string getName() const override {return "Nothing";}
+   const char* getName() const override {return "Nothing";}
+};
+
+// parses one word of command line input. false, leaving value alone, unless
+// the whole word is a T. numbers go through from_chars, so nothing allocates
+template <typename T>
+bool parseWord(std::string_view word, T& value)
+{
+    if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+    {
+        value = T(word);
+        return true;
+    }
+    else if constexpr (std::is_same_v<T, bool>)
+    {
+        if (word == "1" || word == "true") { value = true; return true; }
+        if (word == "0" || word == "false") { value = false; return true; }
+        return false;
+    }
+    else if constexpr (std::is_same_v<T, char>)
+    {
+        if (word.size() != 1) return false;
+        value = word[0];
+        return true;
+    }
+    else
+    {
+        static_assert(std::is_arithmetic_v<T>, "parseWord: no parser for this type");
+        if (word.size() > 1 && word[0] == '+') 
+            word.remove_prefix(1);
+        T parsed;
+        auto [end, error] = std::from_chars(word.data(), word.data() + word.size(), parsed);
+        if (error != std::errc() || end != word.data() + word.size() || word.empty())
+            return false;
+        value = parsed;
+        return true;
+    }
+}
+
+template <typename T>
+constexpr const char* describeWord()
+{
+    if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) return "a word";
+    else if constexpr (std::is_same_v<T, bool>) return "true or false";
+    else if constexpr (std::is_same_v<T, char>) return "a single character";
+    else if constexpr (std::is_integral_v<T>) return "a whole number";
+    else return "a number";
+}
+
+// how a CommandLine::parse went. true if every word parsed, otherwise it
+// names the first word that didn't and what it should have been
+struct ParseResult
+{
+    size_t word{0};
+    const char* expected{nullptr};
+    bool missing{false}; //the input ran out before this word
+    explicit operator bool() const { return !expected; }
 };
 
+inline std::ostream& operator<<(std::ostream& os, const ParseResult& result)
+{
+    if (result)
+        return os << "ok";
+    return os << (result.missing ? "missing word " : "bad word ") << result.word << ", expected " << result.expected;
+}
+
+// the text lives in the event, so making one allocates nothing. the queue's
+// slots are sized by the motion path anyway. it is split into words once, when
+// the event is made, and every accessor reads those spans
 class CommandLine: public Event
 {
 public:
-    void set(std::string input) { this->input = input;}
+    static constexpr size_t maxInput = 512;
+    static constexpr size_t maxWords = 64;
+    // false if the input had to be cut short, at maxInput characters or maxWords words
+    bool set(std::string_view input) 
+    { 
+        length = std::min(input.size(), maxInput);
+        std::copy_n(input.data(), length, text.data());
+        wordCount = 0;
+        size_t i = 0;
+        while (wordCount < maxWords)
+        {
+            while (i < length && std::isspace(static_cast<unsigned char>(text[i]))) i++;
+            if (i == length) break;
+            size_t begin = i;
+            while (i < length && !std::isspace(static_cast<unsigned char>(text[i]))) i++;
+            words[wordCount++] = {static_cast<uint16_t>(begin), static_cast<uint16_t>(i - begin)};
+        }
+        bool moreWords = wordCount == maxWords && getText().find_first_not_of(" \t\n\v\f\r", i) != std::string_view::npos;
+        return length == input.size() && !moreWords;
+    }
     Category getCategory() const override {return Category::CommandLine;}
-    std::string getName() const override {return "CommandLine";};
-    std::string getInput() const {return input;}
-    std::string getFirstWord() const 
+    const char* getName() const override {return "CommandLine";};
+    std::string getInput() const {return std::string(text.data(), length);}
+    std::string_view getText() const {return std::string_view(text.data(), length);}
+    size_t getWordCount() const {return wordCount;}
+    // empty past the last word
+    std::string_view getWord(size_t i) const 
     {
-        std::stringstream ss{input};
-        std::string word; ss >> word;
-        return word;
+        if (i >= wordCount) return {};
+        return std::string_view(text.data() + words[i].begin, words[i].length);
     }
+    // false, leaving value alone, if there is no word i or it isn't a T
     template<typename T>
-    T getFirst() const
-    {
-        std::stringstream ss{input};
-        T item; ss >> item;
-        return item;
-    }
+    bool get(size_t i, T& value) const { return i < wordCount && parseWord(getWord(i), value); }
+    std::string getFirstWord() const {return std::string(getWord(0));}
+    // a default T if the word is missing or isn't a T. use parse to find out which
+    template<typename T>
+    T getFirst() const {return getArg<T, 0>();}
     template<typename T, int I>
-    T getArg()
+    T getArg() const
     {
-        std::stringstream ss{input};
-        std::string catcher;
-        T arg;
-        for (int i = 0; i < I; i++) 
-            ss >> catcher;   
-        ss >> arg; 
+        T arg{};
+        get(I, arg);
         return arg;
     }
-    std::stringstream getStream() const
+    // words first, first + 1 and on into values, in order. stops at the first
+    // word that is missing or doesn't parse and says which
+    template<typename... Ts>
+    ParseResult parse(size_t first, Ts&... values) const
     {
-        return std::stringstream{input};
-    }
-    inline void serialize(std::ofstream& os) {
-        auto cat = getCategory();
-        os.write((char*)&cat, sizeof(Category));
-        size_t inputSize = input.size();
-        os.write((char*)&inputSize, sizeof(size_t));
-        os.write((char*)input.data(), input.size());
-        os.write((char*)&handled, sizeof(bool));
-    }
-    inline void unserialize(std::ifstream& is) {
-        size_t inputSize;
-        is.read((char*)&inputSize, sizeof(size_t));
-        char cstr[inputSize];
-        is.read(cstr, inputSize);
-        input.assign(cstr, inputSize);
-        is.read((char*)&handled, sizeof(bool));
+        ParseResult result;
+        size_t i = first;
+        auto one = [&](auto& value)
+        {
+            using T = std::decay_t<decltype(value)>;
+            if (!result) return;
+            if (!get(i, value))
+                result = {i, describeWord<T>(), i >= wordCount};
+            i++;
+        };
+        (one(values), ...);
+        return result;
     }
 private:
-    std::string input;
+    struct Span
+    {
+        uint16_t begin;
+        uint16_t length;
+    };
+    std::array<char, maxInput> text;
+    size_t length{0};
+    std::array<Span, maxWords> words;
+    size_t wordCount{0};
 };
 
 class Window: public Event
@@ -203,7 +305,7 @@ protected:
 class LeaveWindow : public Window
 {
     WindowEventType getType() const override {return WindowEventType::LeaveWindow;}
-    std::string getName() const override {return "LeaveWindow";};
+    const char* getName() const override {return "LeaveWindow";};
 };
 
 class Keyboard : public Window
@@ -220,7 +322,7 @@ class KeyPress final : public Keyboard
 public:
     void set(int16_t x, int16_t y, symbol::Key key) {xPos = x; yPos = y; this->key = key;}
     WindowEventType getType() const override {return WindowEventType::Keypress;}
-    std::string getName() const override {return "KeyPressEvent";};
+    const char* getName() const override {return "KeyPressEvent";};
 };
 
 class KeyRelease final : public Keyboard
@@ -228,7 +330,7 @@ class KeyRelease final : public Keyboard
 public:
     void set(int16_t x, int16_t y, symbol::Key key) {xPos = x; yPos = y; this->key = key;}
     inline WindowEventType getType() const override {return WindowEventType::Keyrelease;}
-    inline std::string getName() const override {return "KeyReleaseEvent";};
+    inline const char* getName() const override {return "KeyReleaseEvent";};
 };
 
 class MouseButton : public Window
@@ -244,7 +346,7 @@ class MousePress final : public MouseButton
 public:
     void set(int16_t x, int16_t y, symbol::MouseButton button) {xPos = x; yPos = y; this->button = button;}
     inline WindowEventType getType() const override {return WindowEventType::MousePress;}
-    inline std::string getName() const override {return "MousePressEvent";};
+    inline const char* getName() const override {return "MousePressEvent";};
 };
 
 class MouseRelease final : public MouseButton
@@ -252,15 +354,97 @@ class MouseRelease final : public MouseButton
 public:
     void set(int16_t x, int16_t y, symbol::MouseButton button) {xPos = x; yPos = y; this->button = button;}
     inline WindowEventType getType() const override {return WindowEventType::MouseRelease;}
-    inline std::string getName() const override {return "MouseReleaseEvent";};
+    inline const char* getName() const override {return "MouseReleaseEvent";};
+};
+
+struct MotionSample
+{
+    int16_t x;
+    int16_t y;
+    std::chrono::steady_clock::time_point time;
 };
 
+// the dispatcher merges each run of motion between two other events into one
+// of these. getX and getY are where the pointer ended up, which is all most
+// states care about. the path has every position along the way, oldest first
+// and ending at getX, getY, for states that want the whole stroke
 class MouseMotion final : public Window
 {
 public:
-    void set(int16_t x, int16_t y) {xPos = x; yPos = y;}
+    static constexpr size_t maxPath = 64;
+
+    MouseMotion() = default;
+    // only the part of the path in use is copied
+    MouseMotion(const MouseMotion& other) : Window{other}, pathLength{other.pathLength},
+        stride{other.stride}, sinceKept{other.sinceKept}
+    {
+        std::copy_n(other.path.begin(), pathLength, path.begin());
+    }
+    MouseMotion& operator=(const MouseMotion& other)
+    {
+        Window::operator=(other);
+        pathLength = other.pathLength;
+        stride = other.stride;
+        sinceKept = other.sinceKept;
+        std::copy_n(other.path.begin(), pathLength, path.begin());
+        return *this;
+    }
+
+    void set(int16_t x, int16_t y) 
+    {
+        xPos = x; yPos = y;
+        path[0] = {x, y, created};
+        pathLength = 1;
+        stride = 1;
+        sinceKept = 0;
+    }
+    void setCreationTime(std::chrono::steady_clock::time_point time) override
+    {
+        created = time;
+        path[0].time = time;
+    }
+    // the path always holds the first and the latest sample. in between it keeps
+    // every stride'th one, and once it fills up every other of those is dropped
+    // and the stride doubles, so a long stroke is thinned evenly along its length
+    void append(const MouseMotion& later)
+    {
+        for (size_t i = 0; i < later.pathLength; i++) 
+            appendSample(later.path[i]);
+        xPos = later.xPos; yPos = later.yPos;
+    }
+    // whether append would keep every sample of later
+    bool hasRoomFor(const MouseMotion& later) const {return stride == 1 && pathLength + later.pathLength <= maxPath;}
+    const std::array<MotionSample, maxPath>& getPath() const {return path;}
+    size_t getPathLength() const {return pathLength;}
     inline WindowEventType getType() const override {return WindowEventType::Motion;}
-    inline std::string getName() const override {return "MouseMotionEvent";};
+    inline const char* getName() const override {return "MouseMotionEvent";};
+private:
+    std::array<MotionSample, maxPath> path;
+    size_t pathLength{0};
+    uint32_t stride{1};
+    uint32_t sinceKept{0}; //samples since the last one kept; if not 0 the last sample is only the latest
+
+    void appendSample(const MotionSample& sample)
+    {
+        if (sinceKept == 0)
+        {
+            if (pathLength == maxPath)
+                thin();
+            pathLength++;
+        }
+        path[pathLength - 1] = sample;
+        sinceKept = (sinceKept + 1) % stride;
+    }
+    // keeps the first sample, every second one after it and the last
+    void thin()
+    {
+        size_t kept = 1;
+        for (size_t i = 2; i + 1 < pathLength; i += 2) 
+            path[kept++] = path[i];
+        path[kept++] = path[pathLength - 1];
+        pathLength = kept;
+        stride *= 2;
+    }
 };
 
 enum class InputMode : uint8_t
@@ -0,0 +1,325 @@
+#include "eventlog.hpp"
+#include <util/debug.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sword
+{
+
+namespace event
+{
+
+using namespace logformat;
+
+static constexpr size_t flushThreshold = 1 << 16;
+
+LogWriter::~LogWriter()
+{
+    finish();
+}
+
+bool LogWriter::open(const std::string& path)
+{
+    finish();
+    os.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!os.is_open())
+        return false;
+    buffer.reserve(flushThreshold);
+    index.clear();
+    offset = 0;
+    events = 0;
+    lastTime = 0;
+    start = std::chrono::steady_clock::now();
+    FileHeader header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.recordSize = sizeof(Record);
+    append(&header, sizeof(header));
+    return true;
+}
+
+void LogWriter::append(const void* data, size_t size)
+{
+    auto bytes = static_cast<const char*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+    offset += size;
+    if (buffer.size() >= flushThreshold)
+    {
+        os.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+bool LogWriter::write(const Event& event, std::chrono::steady_clock::time_point when)
+{
+    if (!os.is_open())
+        return false;
+    Record record{};
+    record.category = event.getCategory();
+    switch (record.category)
+    {
+        case Category::CommandLine:
+        {
+            writeRecord(record, when);
+            auto input = static_cast<const CommandLine&>(event).getText();
+            uint32_t length = input.size();
+            append(&length, sizeof(length));
+            append(input.data(), length);
+            return true;
+        }
+        case Category::Abort: writeRecord(record, when); return true;
+        case Category::Window:
+        {
+            auto& we = static_cast<const Window&>(event);
+            record.windowType = we.getType();
+            record.x = we.getX();
+            record.y = we.getY();
+            switch (record.windowType)
+            {
+                case WindowEventType::Keypress: case WindowEventType::Keyrelease:
+                    record.detail = static_cast<uint8_t>(static_cast<const Keyboard&>(event).getKey()); break;
+                case WindowEventType::MousePress: case WindowEventType::MouseRelease:
+                    record.detail = static_cast<uint8_t>(static_cast<const MouseButton&>(event).getMouseButton()); break;
+                case WindowEventType::Motion:
+                {
+                    // merged motion goes back to one record per position, so a log
+                    // doesn't depend on how the frames fell
+                    auto& motion = static_cast<const MouseMotion&>(event);
+                    for (size_t i = 0; i < motion.getPathLength(); i++) 
+                    {
+                        auto& sample = motion.getPath()[i];
+                        record.x = sample.x;
+                        record.y = sample.y;
+                        writeRecord(record, sample.time);
+                    }
+                    return true;
+                }
+                default: break;
+            }
+            writeRecord(record, when);
+            return true;
+        }
+        default: return false;
+    }
+}
+
+// command line records still need their text appended after this
+void LogWriter::writeRecord(Record& record, std::chrono::steady_clock::time_point when)
+{
+    // events from different threads can reach us slightly out of creation order
+    auto sinceStart = std::chrono::duration_cast<std::chrono::nanoseconds>(when - start).count();
+    lastTime = std::max<uint64_t>(lastTime, sinceStart > 0 ? sinceStart : 0);
+    record.time = lastTime;
+
+    if (events % indexStride == 0)
+        index.push_back({events, offset, record.time});
+    append(&record, sizeof(record));
+    events++;
+}
+
+void LogWriter::flush()
+{
+    if (!os.is_open() || buffer.empty())
+        return;
+    os.write(buffer.data(), buffer.size());
+    os.flush();
+    buffer.clear();
+}
+
+void LogWriter::finish()
+{
+    if (!os.is_open())
+        return;
+    Footer footer{};
+    footer.indexOffset = offset;
+    footer.indexCount = index.size();
+    footer.eventCount = events;
+    std::memcpy(footer.magic, footerMagic, sizeof(footerMagic));
+    if (!index.empty())
+        append(index.data(), index.size() * sizeof(IndexEntry));
+    append(&footer, sizeof(footer));
+    flush();
+    os.close();
+}
+
+LogReader::~LogReader()
+{
+    close();
+}
+
+void LogReader::close()
+{
+    if (data)
+        munmap(const_cast<uint8_t*>(data), size);
+    data = nullptr;
+    size = 0;
+    mappedEmpty = false;
+    recordsBegin = recordsEnd = offset = 0;
+    eventIndex = footerEvents = 0;
+    version = 0;
+    index.clear();
+}
+
+bool LogReader::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        ::close(fd);
+        return false;
+    }
+    size = st.st_size;
+    if (size == 0)
+    {
+        ::close(fd);
+        mappedEmpty = true;
+        version = 1;
+        return true;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        size = 0;
+        return false;
+    }
+    data = static_cast<const uint8_t*>(mapped);
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    FileHeader header;
+    if (size >= sizeof(header) && std::memcmp(data, magic, sizeof(magic)) == 0)
+    {
+        std::memcpy(&header, data, sizeof(header));
+        if (header.version > logformat::version || header.recordSize != sizeof(Record))
+        {
+            std::cerr << "LogReader::open: " << path << " is event log version " << header.version
+                << ", this build reads up to " << logformat::version << '\n';
+            close();
+            return false;
+        }
+        version = header.version;
+        recordsBegin = sizeof(header);
+        recordsEnd = size;
+        Footer footer;
+        if (size >= recordsBegin + sizeof(footer))
+        {
+            std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+            size_t indexBytes = footer.indexCount * sizeof(IndexEntry);
+            if (std::memcmp(footer.magic, footerMagic, sizeof(footerMagic)) == 0 &&
+                footer.indexOffset >= recordsBegin &&
+                footer.indexOffset + indexBytes + sizeof(footer) == size)
+            {
+                recordsEnd = footer.indexOffset;
+                footerEvents = footer.eventCount;
+                index.resize(footer.indexCount);
+                if (indexBytes)
+                    std::memcpy(index.data(), data + footer.indexOffset, indexBytes);
+            }
+        }
+    }
+    else
+    {
+        version = 1;
+        recordsBegin = 0;
+        recordsEnd = size;
+    }
+    offset = recordsBegin;
+    SWD_DEBUG_MSG("opened " << path << " version " << version << " events " << footerEvents);
+    return true;
+}
+
+bool LogReader::next(LogRecord& record)
+{
+    if (atEnd())
+        return false;
+    bool ok = version == 1 ? nextV1(record) : nextV2(record);
+    if (!ok)
+    {
+        std::cerr << "LogReader::next: malformed record at byte " << offset << ", stopping" << '\n';
+        offset = recordsEnd;
+        return false;
+    }
+    eventIndex++;
+    return true;
+}
+
+bool LogReader::nextV1(LogRecord& record)
+{
+    record = LogRecord{};
+    record.category = static_cast<Category>(data[offset]);
+    size_t at = offset + 1;
+    if (record.category == Category::CommandLine)
+    {
+        size_t length;
+        if (at + sizeof(length) > recordsEnd) return false;
+        std::memcpy(&length, data + at, sizeof(length));
+        at += sizeof(length);
+        if (length > recordsEnd - at || at + length + sizeof(bool) > recordsEnd) return false;
+        record.text = std::string_view(reinterpret_cast<const char*>(data + at), length);
+        at += length + sizeof(bool); //handled flag, always false when written
+    }
+    else if (record.category != Category::Abort)
+        return false;
+    offset = at;
+    return true;
+}
+
+bool LogReader::nextV2(LogRecord& record)
+{
+    Record raw;
+    if (offset + sizeof(raw) > recordsEnd) return false;
+    std::memcpy(&raw, data + offset, sizeof(raw));
+    size_t at = offset + sizeof(raw);
+    record = LogRecord{};
+    record.time = raw.time;
+    record.category = raw.category;
+    record.windowType = raw.windowType;
+    record.detail = raw.detail;
+    record.x = raw.x;
+    record.y = raw.y;
+    if (raw.category == Category::CommandLine)
+    {
+        uint32_t length;
+        if (at + sizeof(length) > recordsEnd) return false;
+        std::memcpy(&length, data + at, sizeof(length));
+        at += sizeof(length);
+        if (length > recordsEnd - at) return false;
+        record.text = std::string_view(reinterpret_cast<const char*>(data + at), length);
+        at += length;
+    }
+    offset = at;
+    return true;
+}
+
+bool LogReader::seek(uint64_t target)
+{
+    if (!isOpen())
+        return false;
+    offset = recordsBegin;
+    eventIndex = 0;
+    auto after = std::upper_bound(index.begin(), index.end(), target,
+            [](uint64_t t, const IndexEntry& e) { return t < e.event; });
+    if (after != index.begin())
+    {
+        auto& entry = *(after - 1);
+        offset = entry.offset;
+        eventIndex = entry.event;
+    }
+    LogRecord skipped;
+    while (eventIndex < target)
+        if (!next(skipped))
+            return false;
+    return true;
+}
+
+}; // namespace event
+
+}; // namespace sword
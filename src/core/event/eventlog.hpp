@@ -0,0 +1,166 @@
+#ifndef EVENT_EVENTLOG_HPP
+#define EVENT_EVENTLOG_HPP
+
+//imp: event/eventlog.cpp
+
+#include "event.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sword
+{
+
+namespace event
+{
+
+// v2 layout, all little endian:
+//   FileHeader
+//   Record...             command line records are followed by a uint32 length and the text
+//   IndexEntry...         one every indexStride events
+//   Footer                at the very end, so a reader finds it without scanning
+// a log cut short by a crash has no index or footer; readers then just scan.
+// v1 logs have no header: a category byte, then for command lines a size_t
+// length, the text and a handled flag. they carry no time and only command
+// line and abort events.
+namespace logformat
+{
+
+constexpr char magic[8] = {'S', 'W', 'D', 'E', 'V', 'L', 'O', 'G'};
+constexpr char footerMagic[8] = {'S', 'W', 'D', 'I', 'N', 'D', 'E', 'X'};
+constexpr uint16_t version = 2;
+constexpr uint64_t indexStride = 256;
+
+struct FileHeader
+{
+    char magic[8];
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t reserved;
+};
+
+struct Record
+{
+    uint64_t time; //ns since recording started, never goes backwards
+    Category category;
+    WindowEventType windowType;
+    uint8_t detail; //mouse button or key
+    uint8_t reserved;
+    int16_t x;
+    int16_t y;
+};
+
+struct IndexEntry
+{
+    uint64_t event;
+    uint64_t offset;
+    uint64_t time;
+};
+
+struct Footer
+{
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t eventCount;
+    char magic[8];
+};
+
+static_assert(sizeof(FileHeader) == 16);
+static_assert(sizeof(Record) == 16);
+static_assert(sizeof(Footer) == 32);
+
+}; // namespace logformat
+
+// one event as read back from a log
+struct LogRecord
+{
+    uint64_t time{0}; //0 for v1 logs
+    Category category{Category::Nothing};
+    WindowEventType windowType{WindowEventType::Motion};
+    uint8_t detail{0};
+    int16_t x{0};
+    int16_t y{0};
+    std::string_view text; //command line input. points into the mapped file
+};
+
+// stays open for the whole session and writes through its own buffer.
+// call flush to push what is buffered to the file, finish (or destroy it) to
+// write the index and footer
+class LogWriter
+{
+public:
+    LogWriter() = default;
+    ~LogWriter();
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    bool open(const std::string& path); //truncates
+    bool isOpen() const { return os.is_open(); }
+    // events that can't be replayed (file events, frame markers) are skipped.
+    // merged motion is written out one position at a time.
+    // returns whether it was written
+    bool write(const Event&, std::chrono::steady_clock::time_point when);
+    void flush();
+    void finish();
+    uint64_t eventCount() const { return events; }
+    uint64_t lastEventTime() const { return lastTime; }
+
+private:
+    std::ofstream os;
+    std::vector<char> buffer;
+    std::vector<logformat::IndexEntry> index;
+    std::chrono::steady_clock::time_point start;
+    uint64_t offset{0};
+    uint64_t events{0};
+    uint64_t lastTime{0};
+
+    void append(const void* data, size_t size);
+    void writeRecord(logformat::Record&, std::chrono::steady_clock::time_point when);
+};
+
+// maps the whole log and hands records out in order. reads both v1 and v2
+class LogReader
+{
+public:
+    LogReader() = default;
+    ~LogReader();
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data != nullptr || mappedEmpty; }
+    bool atEnd() const { return offset >= recordsEnd; }
+    // false at the end or if the rest of the log is malformed
+    bool next(LogRecord&);
+    // positions the reader so next() returns event number eventIndex. uses the
+    // footer index when there is one
+    bool seek(uint64_t eventIndex);
+    uint64_t position() const { return eventIndex; }
+    uint16_t getVersion() const { return version; }
+    // 0 when the log has no footer
+    uint64_t eventCount() const { return footerEvents; }
+
+private:
+    const uint8_t* data{nullptr};
+    size_t size{0};
+    bool mappedEmpty{false};
+    size_t recordsBegin{0};
+    size_t recordsEnd{0};
+    size_t offset{0};
+    uint64_t eventIndex{0};
+    uint64_t footerEvents{0};
+    uint16_t version{0};
+    std::vector<logformat::IndexEntry> index;
+
+    bool nextV1(LogRecord&);
+    bool nextV2(LogRecord&);
+};
+
+}; // namespace event
+
+}; // namespace sword
+
+#endif /* end of include guard: EVENT_EVENTLOG_HPP */
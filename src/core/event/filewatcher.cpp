@@ -2,7 +2,11 @@
 #include <unistd.h>
 #include <iostream>
 #include <util/outformat.hpp>
+#include <util/debug.hpp>
 #include <sys/inotify.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <cerrno>
 #include <filesystem>
 
 namespace sword
@@ -14,8 +18,34 @@ namespace event
 FileWatcher::FileWatcher(EventQueue& queue) :
     eventQueue{queue}
 {
-    fd = inotify_init();
-    std::cout << "Inotify init called" << '\n';
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stopfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (fd == -1 || stopfd == -1 || epfd == -1)
+    {
+        SWD_LOG(error, "FileWatcher: could not set up inotify or epoll");
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    ev.data.fd = stopfd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, stopfd, &ev);
+    SWD_DEBUG_MSG("Inotify init called");
+}
+
+FileWatcher::~FileWatcher()
+{
+    shutdown();
+    for (int descriptor : {epfd, stopfd, fd}) 
+        if (descriptor != -1)
+            close(descriptor);
+}
+
+void FileWatcher::start()
+{
+    thread = std::thread(&FileWatcher::run, this);
 }
 
 // due to the way vim operates, we cannot watch the file itself.
@@ -23,47 +53,192 @@ FileWatcher::FileWatcher(EventQueue& queue) :
 // this is actually a good thing as it ensures we don't ever try to to compile 
 // the file mid-write. instead, we watch the directory, and then only generate
 // an event when the read buffer contains the name of the file we actually want 
-// to watch
+// to watch. editors that write elsewhere and rename over the file show up as
+// a move into the directory instead of a close
 bool FileWatcher::addWatch(const char* path_str)
 {
     std::filesystem::path path{path_str};
     auto parent = path.parent_path();
-    std::cerr << "FileWatcher::addWatch: Adding watch to dir:" << parent.c_str() << '\n';
-    int watch = inotify_add_watch(fd, parent.c_str(), IN_CLOSE_WRITE);
+    SWD_DEBUG_MSG("Adding watch to dir: " << parent.c_str());
+    int watch = inotify_add_watch(fd, parent.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MASK_ADD);
     if (watch == -1)
         return false;
     std::string name = path.filename();
-    watches.push_back({watch, path_str, name});
-    std::cout << "watching " << name << '\n';
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!watches.try_emplace(Key{watch, name}, WatchTicket{watch, path_str, name, false, {}}).second)
+            return true; //already watching
+    }
+    SWD_LOG(info, "watching " << name);
+    return true;
+}
+
+static constexpr uint32_t treeEvents = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+// mask added, so a directory holding watched files keeps their events too
+bool FileWatcher::watchDir(const std::string& dir, size_t tree)
+{
+    int watch = inotify_add_watch(fd, dir.c_str(), treeEvents | IN_MASK_ADD);
+    if (watch == -1)
+        return false;
+    treeDirs[watch] = {dir, tree};
+    return true;
+}
+
+void FileWatcher::watchDirsUnder(const std::string& dir, size_t tree)
+{
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir, ec)) 
+        if (entry.is_directory())
+            watchDir(entry.path().string(), tree);
+}
+
+bool FileWatcher::watchTree(const char* root, TreeFn fn, std::function<void()> lost)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    size_t tree = trees.size();
+    trees.push_back({root, std::move(fn), std::move(lost)});
+    if (!watchDir(root, tree))
+        return false;
+    watchDirsUnder(root, tree);
     return true;
 }
 
+// directories made while events were dropped were never followed. adding a
+// watch twice just gives back the same wd
+void FileWatcher::rescanTrees()
+{
+    for (size_t tree = 0; tree < trees.size(); tree++) 
+    {
+        if (watchDir(trees[tree].root, tree))
+            watchDirsUnder(trees[tree].root, tree);
+        if (trees[tree].lost)
+            trees[tree].lost();
+    }
+}
+
+void FileWatcher::arm(WatchTicket& ticket, std::chrono::steady_clock::time_point now)
+{
+    ticket.due = now + debounce;
+    if (!ticket.pending)
+    {
+        ticket.pending = true;
+        pending.push_back(&ticket);
+    }
+}
+
+// the kernel dropped events, so any of the files may have been saved
+void FileWatcher::armAll(std::chrono::steady_clock::time_point now)
+{
+    for (auto& [key, ticket] : watches) 
+        arm(ticket, now);
+}
+
+void FileWatcher::treeEvent(const TreeDir& dir, const char* name, uint32_t mask)
+{
+    bool added = mask & (IN_CREATE | IN_MOVED_TO);
+    bool isDir = mask & IN_ISDIR;
+    auto path = dir.path + '/' + name;
+    auto tree = dir.tree; //dir may not survive watchDir growing the map
+    if (added && isDir)
+    {
+        watchDir(path, tree);
+        watchDirsUnder(path, tree);
+    }
+    trees[tree].fn(path, added, isDir);
+}
+
+void FileWatcher::readEvents()
+{
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t numRead = read(fd, buffer, sizeof(buffer));
+        if (numRead <= 0)
+        {
+            if (numRead == -1 && errno != EAGAIN && errno != EINTR)
+                SWD_LOG(warn, "FileWatcher::run: inotify read failed");
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> guard(lock);
+        for (char* p = buffer; p < buffer + numRead; )
+        {
+            auto in_event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + in_event->len;
+            if (in_event->mask & IN_Q_OVERFLOW)
+            {
+                armAll(now);
+                rescanTrees();
+                continue;
+            }
+            if (in_event->mask & IN_IGNORED)
+            {
+                treeDirs.erase(in_event->wd); //the directory is gone
+                continue;
+            }
+            if (!in_event->len)
+                continue;
+            auto it = watches.find(Key{in_event->wd, in_event->name});
+            if (it != watches.end() && (in_event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+                arm(it->second, now);
+            auto dir = treeDirs.find(in_event->wd);
+            if (dir != treeDirs.end() && (in_event->mask & treeEvents))
+                treeEvent(dir->second, in_event->name, in_event->mask);
+        }
+    }
+}
+
+int FileWatcher::publishDue()
+{
+    auto now = std::chrono::steady_clock::now();
+    auto next = std::chrono::steady_clock::time_point::max();
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < pending.size(); )
+    {
+        auto& ticket = *pending[i];
+        if (ticket.due > now)
+        {
+            next = std::min(next, ticket.due);
+            i++;
+            continue;
+        }
+        if (!eventQueue.push(Any::make<File>(ticket.wd, ticket.fullpath.c_str())))
+        {
+            //the queue is full, a drag say. try again once it has had time to drain
+            ticket.due = now + debounce;
+            next = std::min(next, ticket.due);
+            i++;
+            continue;
+        }
+        ticket.pending = false;
+        SWD_LOG(info, "Rustle in " << ticket.filename << " detected.");
+        pending[i] = pending.back();
+        pending.pop_back();
+    }
+    if (pending.empty())
+        return -1;
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(next - now);
+    return static_cast<int>(wait.count());
+}
+
 void FileWatcher::run()
 {
     SWD_THREAD_MSG("File watcher thread started.");
+    int timeout = -1;
     while (!shouldStop)
     {
-//        constexpr int buffer_len{sizeof(inotify_event) + name_max_len + 1};
-        char buffer[1024];
-        size_t numRead = read(fd, buffer, 1024);
-        if (numRead < 1)
-            std::cerr << "Did not read anything" << '\n';
-        auto in_event = reinterpret_cast<inotify_event*>(buffer);
-        std::cerr << "FileWatcher::run: read something..." << '\n';
-        for (const auto& w : watches) 
+        epoll_event events[2];
+        int n = epoll_wait(epfd, events, 2, timeout);
+        if (n == -1 && errno != EINTR)
         {
-            std::cerr << "w.wd: " << w.wd << '\n';
-            std::cerr << "in_event->wd: " << in_event->wd << '\n';
-            std::cerr << "w.filename: " << w.filename << '\n';
-            std::cerr << "in_event->name: " << in_event->name  << '\n';
-
-            if (w.wd == in_event->wd && w.filename == in_event->name)
-            {
-                auto event = eventPool.request(w.wd, w.fullpath);
-                eventQueue.push(std::move(event));
-                std::cout << "Rustle in " << w.filename << " detected." << '\n';
-            }
+            SWD_LOG(warn, "FileWatcher::run: epoll_wait failed");
+            break;
         }
+        for (int i = 0; i < n; i++) 
+            if (events[i].data.fd == fd)
+                readEvents();
+        timeout = publishDue();
     }
     SWD_THREAD_MSG("File watcher thread exitted.");
 }
@@ -71,6 +246,16 @@ void FileWatcher::run()
 void FileWatcher::stop()
 {
     shouldStop = true;
+    uint64_t one = 1;
+    if (stopfd != -1)
+        write(stopfd, &one, sizeof(one));
+}
+
+void FileWatcher::shutdown()
+{
+    stop();
+    if (thread.joinable())
+        thread.join();
 }
 
 }; // namespace event
@@ -3,8 +3,15 @@
 
 #include <string>
 #include "types.hpp"
+#include "queue.hpp"
 #include "event.hpp"
-#include <types/map.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace sword
 {
@@ -15,26 +22,78 @@ namespace event
 struct WatchTicket
 {
     int wd;
-    const char* fullpath;
+    std::string fullpath; //File events point into this, so tickets are never moved or removed
     std::string filename;
+    bool pending{false};
+    std::chrono::steady_clock::time_point due;
 };
 
+// a save is rarely one inotify event: editors write, rename and close in a
+// burst. so a hit on a watched file only arms it, and the File event goes out
+// once the file has been quiet for debounce. the thread sleeps in epoll on the
+// inotify fd and an eventfd that stop writes to
 class FileWatcher
 {
 public:
     FileWatcher(EventQueue& queue);
+    ~FileWatcher();
+    void start(); //runs the watcher on its own thread, joined when we are destroyed
     void run();
     void stop();
+    void shutdown(); //stops the thread and waits for it
     bool addWatch(const char* path); //all watchers will be modify for now
+    // fn hears of every file and directory made or removed under root, on the
+    // watcher thread. new directories are followed as they appear. if the kernel
+    // drops events, lost is called instead, since the tree may have changed
+    // without a word, and the directories are looked for again
+    using TreeFn = std::function<void(const std::string& path, bool added, bool isDir)>;
+    bool watchTree(const char* root, TreeFn fn, std::function<void()> lost = nullptr);
 
+    static constexpr std::chrono::milliseconds debounce{20};
 private:
-    static constexpr int name_max_len{30}; //no shader filename can be longer than this
+    struct Key
+    {
+        int wd;
+        std::string name;
+        bool operator==(const Key& other) const { return wd == other.wd && name == other.name; }
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const { return std::hash<std::string>{}(key.name) ^ (size_t(key.wd) * 0x9e3779b97f4a7c15ull); }
+    };
+
+    struct Tree
+    {
+        std::string root;
+        TreeFn fn;
+        std::function<void()> lost;
+    };
+    struct TreeDir
+    {
+        std::string path;
+        size_t tree; //into trees
+    };
+
+    bool watchDir(const std::string& dir, size_t tree);
+    void watchDirsUnder(const std::string& dir, size_t tree);
+    void rescanTrees();
+    void readEvents();
+    void treeEvent(const TreeDir&, const char* name, uint32_t mask);
+    void arm(WatchTicket&, std::chrono::steady_clock::time_point now);
+    void armAll(std::chrono::steady_clock::time_point now);
+    int publishDue(); //returns ms until the next pending file is due, or -1 if none is
+
     int fd;
-    bool shouldStop{false};
+    int epfd;
+    int stopfd;
+    std::atomic<bool> shouldStop{false};
+    std::thread thread;
     EventQueue& eventQueue;
-    std::vector<WatchTicket> watches;
-
-    Pool<File, 3> eventPool;
+    std::mutex lock; //watches are added from command workers
+    std::unordered_map<Key, WatchTicket, KeyHash> watches;
+    std::vector<WatchTicket*> pending;
+    std::vector<Tree> trees;
+    std::unordered_map<int, TreeDir> treeDirs; //by wd
 };
 
 }; // namespace event
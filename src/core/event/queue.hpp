@@ -2,20 +2,37 @@
 #define EVENT_QUEUE_HPP
 
 #include "event/types.hpp"
+#include <functional>
+
 namespace sword
 {
 
 namespace event
 {
 
-class EventQueue
+// the ring every input thread pushes into. onPush lets whoever drains it
+// sleep until there is something to drain
+class EventQueue : public container::MpscQueue<Any, 256>
 {
 public:
-    void push(EventPtr&& eventPtr) { queue[curSize] = eventPtr; }
+    bool push(Any&& event)
+    {
+        bool pushed = MpscQueue::push(std::move(event));
+        if (onPush)
+            onPush();
+        return pushed;
+    }
+    // wakes the drainer once for the whole batch
+    size_t pushBatch(Any* events, size_t n)
+    {
+        size_t pushed = MpscQueue::pushBatch(events, n);
+        if (onPush && n)
+            onPush();
+        return pushed;
+    }
+    void setOnPush(std::function<void()> fn) { onPush = fn; }
 private:
-    int curSize{0};
-    static constexpr int maxSize = 50;
-    std::array<EventPtr, maxSize> queue;
+    std::function<void()> onPush{nullptr};
 };
 
 }; // namespace event
@@ -3,9 +3,11 @@
 
 #include <memory>
 #include <functional>
+#include <type_traits>
+#include <variant>
 #include <types/stack.hpp>
-#include <types/pool.hpp>
 #include <types/queue.hpp>
+#include "event.hpp"
 
 namespace sword
 {
@@ -13,14 +15,90 @@ namespace sword
 namespace event
 {
 
-class Event;
+// lets a set of lambdas be one visitor:
+//   event.visit(Overload{[](MouseMotion& m) {...}, [](auto&) {}});
+template <typename... Fs> struct Overload : Fs... { using Fs::operator()...; };
+template <typename... Fs> Overload(Fs...) -> Overload<Fs...>;
 
-template <typename T, size_t N>
-using Pool = container::Pool<T, Event, N>;
+// one event of any kind, by value. this is what goes through the event queue,
+// so input costs no allocation on the way in and the frame reads it straight
+// out of the ring. empty until made with make<T>(args), which calls T::set(args).
+// get and -> give the plain Event for states that take one, visit and getIf
+// reach the concrete type without going through its virtuals
+class Any
+{
+public:
+    using Payload = std::variant<std::monostate, CommandLine, Abort, File, KeyPress, KeyRelease,
+          MousePress, MouseRelease, MouseMotion, LeaveWindow>;
+
+    Any() = default;
+
+    template <typename T, typename... Args>
+    static Any make(Args&&... args)
+    {
+        Any any;
+        any.emplace<T>().set(std::forward<Args>(args)...);
+        return any;
+    }
+
+    // a fresh T in place of whatever was here, for when set's result matters
+    template <typename T>
+    T& emplace() { return payload.template emplace<T>(); }
+
+    explicit operator bool() const { return !std::holds_alternative<std::monostate>(payload); }
 
-using Vessel = container::PoolVessel<Event>;
+    Event* get() { return std::visit(asEvent<Event>{}, payload); }
+    const Event* get() const { return std::visit(asEvent<const Event>{}, payload); }
+    Event* operator->() { return get(); }
+    const Event* operator->() const { return get(); }
 
-using EventQueue = container::LockingQueue<Vessel, 200>;
+    template <typename T> T* getIf() { return std::get_if<T>(&payload); }
+    template <typename T> const T* getIf() const { return std::get_if<T>(&payload); }
+
+    // f is called with the event as its concrete type, or with std::monostate if empty
+    template <typename F> decltype(auto) visit(F&& f) { return std::visit(std::forward<F>(f), payload); }
+    template <typename F> decltype(auto) visit(F&& f) const { return std::visit(std::forward<F>(f), payload); }
+
+private:
+    template <typename E>
+    struct asEvent
+    {
+        template <typename T> E* operator()(T& event) const 
+        { 
+            if constexpr (std::is_same_v<std::remove_const_t<T>, std::monostate>)
+                return nullptr;
+            else
+                return &event; 
+        }
+    };
+
+    Payload payload;
+};
+
+// the same visit for states, which are handed a plain Event. one switch on the
+// kind instead of a chain of getCategory and getType checks in every handler
+template <typename F>
+void visit(Event& event, F&& f)
+{
+    switch (event.getCategory())
+    {
+        case Category::CommandLine: f(static_cast<CommandLine&>(event)); return;
+        case Category::Abort: f(static_cast<Abort&>(event)); return;
+        case Category::File: f(static_cast<File&>(event)); return;
+        case Category::Window: break;
+        default: return;
+    }
+    switch (static_cast<Window&>(event).getType())
+    {
+        case WindowEventType::Keypress: f(static_cast<KeyPress&>(event)); return;
+        case WindowEventType::Keyrelease: f(static_cast<KeyRelease&>(event)); return;
+        case WindowEventType::MousePress: f(static_cast<MousePress&>(event)); return;
+        case WindowEventType::MouseRelease: f(static_cast<MouseRelease&>(event)); return;
+        case WindowEventType::Motion: f(static_cast<MouseMotion&>(event)); return;
+        case WindowEventType::LeaveWindow: f(static_cast<LeaveWindow&>(event)); return;
+        default: return;
+    }
+}
 
 }; // namespace event
 
@@ -0,0 +1,156 @@
+#include "vocabindex.hpp"
+#include <state/vocab.hpp>
+#include <algorithm>
+
+namespace sword
+{
+
+namespace event
+{
+
+// a masked vocab only ever offers its first 32 words, as many bits as the mask has
+bool VocabIndex::counts(const Layer& layer, size_t i)
+{
+    if (!layer.masked)
+        return true;
+    return i < layer.counted.size() && layer.counted[i];
+}
+
+uint32_t VocabIndex::intern(const std::string& word)
+{
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), word, 
+            [this](uint32_t id, const std::string& w) { return entries[id].word < w; });
+    if (it != sorted.end() && entries[*it].word == word)
+        return *it;
+    uint32_t id = entries.size();
+    entries.push_back({word, 0});
+    sorted.insert(it, id);
+    return id;
+}
+
+void VocabIndex::count(Layer& layer)
+{
+    auto mask = layer.vocab->getMask();
+    layer.masked = mask != nullptr;
+    layer.counted = mask ? *mask : state::OptionMask{};
+    for (size_t i = 0; i < layer.ids.size(); i++) 
+        if (counts(layer, i))
+            entries[layer.ids[i]].live++;
+}
+
+void VocabIndex::uncount(Layer& layer)
+{
+    for (size_t i = 0; i < layer.ids.size(); i++) 
+        if (counts(layer, i))
+            entries[layer.ids[i]].live--;
+}
+
+void VocabIndex::applyMask(Layer& layer)
+{
+    auto mask = layer.vocab->getMask();
+    if (layer.masked != (mask != nullptr))
+    {
+        uncount(layer);
+        count(layer);
+        return;
+    }
+    if (!mask)
+        return;
+    auto flipped = layer.counted ^ *mask;
+    size_t n = std::min(layer.ids.size(), flipped.size());
+    for (size_t i = 0; i < n; i++) 
+    {
+        if (!flipped[i])
+            continue;
+        if ((*mask)[i])
+            entries[layer.ids[i]].live++;
+        else
+            entries[layer.ids[i]].live--;
+    }
+    layer.counted = *mask;
+}
+
+void VocabIndex::push(const state::Vocab* vocab)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    Layer layer;
+    layer.vocab = vocab;
+    layer.version = vocab->getVersion();
+    for (const auto& word : vocab->getAllWords()) 
+        layer.ids.push_back(intern(word));
+    count(layer);
+    layers.push_back(std::move(layer));
+    replaced = false;
+}
+
+void VocabIndex::pop()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (layers.empty())
+        return;
+    uncount(layers.back());
+    layers.pop_back();
+    replaced = false;
+}
+
+void VocabIndex::refresh()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto& layer : layers) 
+    {
+        if (layer.version != layer.vocab->getVersion())
+        {
+            uncount(layer);
+            layer.ids.clear();
+            for (const auto& word : layer.vocab->getAllWords()) 
+                layer.ids.push_back(intern(word));
+            layer.version = layer.vocab->getVersion();
+            count(layer);
+        }
+        else
+            applyMask(layer);
+    }
+    replaced = false;
+}
+
+void VocabIndex::replace(std::vector<std::string> words)
+{
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    std::lock_guard<std::mutex> guard(lock);
+    replacement = std::move(words);
+    replaced = true;
+}
+
+std::vector<std::string> VocabIndex::complete(std::string_view prefix) const
+{
+    auto hasPrefix = [prefix](std::string_view word) { return word.substr(0, prefix.size()) == prefix; };
+    std::vector<std::string> matches;
+    std::lock_guard<std::mutex> guard(lock);
+    if (replaced)
+    {
+        auto it = std::lower_bound(replacement.begin(), replacement.end(), prefix, 
+                [](const std::string& word, std::string_view p) { return std::string_view(word) < p; });
+        for (; it != replacement.end() && hasPrefix(*it); it++) 
+            matches.push_back(*it);
+        return matches;
+    }
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), prefix, 
+            [this](uint32_t id, std::string_view p) { return std::string_view(entries[id].word) < p; });
+    for (; it != sorted.end() && hasPrefix(entries[*it].word); it++) 
+        if (entries[*it].live)
+            matches.push_back(entries[*it].word);
+    return matches;
+}
+
+size_t VocabIndex::liveWords() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (replaced)
+        return replacement.size();
+    return std::count_if(entries.begin(), entries.end(), [](const Entry& e) { return e.live > 0; });
+}
+
+}; // namespace event
+
+}; // namespace sword
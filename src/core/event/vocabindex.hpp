@@ -0,0 +1,70 @@
+#ifndef EVENT_VOCABINDEX_HPP
+#define EVENT_VOCABINDEX_HPP
+
+//imp: event/vocabindex.cpp
+
+#include <state/option.hpp>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sword
+{
+
+namespace state { class Vocab; }
+
+namespace event
+{
+
+// the words readline completes from. every word ever seen is kept once, in a
+// sorted array, with a count of the pushed vocabs that currently offer it, so
+// a completion is a binary search for the prefix and a walk over the words
+// that share it. pushing a vocab counts its words in, refresh applies whatever
+// changed in the pushed vocabs since: only the flipped mask bits if the words
+// are the same, the words themselves if they aren't. a leaf's words replace
+// the stack's until the next push, pop or refresh.
+// completion runs on the command line thread, the rest on command workers
+class VocabIndex
+{
+public:
+    void push(const state::Vocab*);
+    void pop();
+    void refresh();
+    void replace(std::vector<std::string> words);
+    std::vector<std::string> complete(std::string_view prefix) const; //in order, no repeats
+    size_t liveWords() const;
+private:
+    struct Entry
+    {
+        std::string word;
+        uint32_t live{0}; //pushed vocabs offering it right now
+    };
+    struct Layer
+    {
+        const state::Vocab* vocab;
+        uint64_t version;
+        std::vector<uint32_t> ids; //entry of each of the vocab's words, in its order
+        bool masked;
+        state::OptionMask counted; //the mask as it was when we last counted
+    };
+
+    uint32_t intern(const std::string& word);
+    void count(Layer&);
+    void uncount(Layer&);
+    void applyMask(Layer&);
+    static bool counts(const Layer&, size_t i);
+
+    mutable std::mutex lock;
+    std::vector<Entry> entries;
+    std::vector<uint32_t> sorted; //entries by word
+    std::vector<Layer> layers;
+    std::vector<std::string> replacement; //sorted, used instead of the layers when replaced
+    bool replaced{false};
+};
+
+}; // namespace event
+
+}; // namespace sword
+
+#endif /* end of include guard: EVENT_VOCABINDEX_HPP */
@@ -15,7 +15,7 @@ Attachment::Attachment(
 	device{device},
 	extent{extent}
 {
-    SWD_DEBUG_MSG("Device" << device);
+    SWD_TRACE_MSG("Device" << device);
 	vk::Extent3D ex = {extent.width, extent.height, 1};
 	format = standard::imageFormat;
 	auto image = std::make_unique<Image>(
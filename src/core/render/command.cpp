@@ -173,6 +173,13 @@ void CommandBuffer::copyImageToBuffer(
             image, vk::ImageLayout::eTransferSrcOptimal, buffer, region);
 }
 
+void CommandBuffer::copyBufferToImage(
+        vk::Buffer& buffer, vk::Image& image, vk::BufferImageCopy region)
+{
+    handle->copyBufferToImage(
+            buffer, image, vk::ImageLayout::eTransferDstOptimal, region);
+}
+
 void CommandBuffer::copyImageToImage(vk::Image& from, vk::Image& to, vk::ImageCopy region)
 {
     handle->copyImage(from, vk::ImageLayout::eTransferSrcOptimal, 
@@ -74,6 +74,7 @@ public:
     vk::PipelineStageFlags dstStageMask,
     vk::ImageMemoryBarrier imb);
     void copyImageToBuffer(vk::Image&, vk::Buffer&, vk::BufferImageCopy);
+    void copyBufferToImage(vk::Buffer&, vk::Image&, vk::BufferImageCopy);
     void copyImageToImage(vk::Image&, vk::Image&, vk::ImageCopy);
     void endRenderPass();
     void end();
@@ -0,0 +1,136 @@
+#include "dependencygraph.hpp"
+#include <util/threadpool.hpp>
+#include <algorithm>
+
+namespace sword
+{
+
+namespace render
+{
+
+DependencyGraph::DependencyGraph(util::ThreadPool& pool) :
+    pool{pool}
+{}
+
+void DependencyGraph::dependOn(const NodePtr& node, const NodePtr& on)
+{
+    if (!on || on->done || on == node) return;
+    on->dependents.push_back(node);
+    node->waitingOn++;
+}
+
+void DependencyGraph::submit(const std::optional<Dependencies>& deps, Job job)
+{
+    auto node = std::make_shared<Node>();
+    node->job = std::move(job);
+    bool ready;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        dependOn(node, barrier);
+        if (!deps)
+        {
+            node->isBarrier = true;
+            for (const auto& prev : sinceBarrier)
+                dependOn(node, prev);
+            writers.clear();
+            readers.clear();
+            sinceBarrier.clear();
+            barrier = node;
+        }
+        else
+        {
+            node->uses = *deps;
+            for (const auto& name : deps->reads)
+            {
+                auto w = writers.find(name);
+                if (w != writers.end()) dependOn(node, w->second);
+            }
+            for (const auto& name : deps->writes)
+            {
+                auto w = writers.find(name);
+                if (w != writers.end()) dependOn(node, w->second);
+                auto r = readers.find(name);
+                if (r != readers.end())
+                    for (const auto& reader : r->second)
+                        dependOn(node, reader);
+            }
+            for (const auto& name : deps->reads)
+                readers[name].push_back(node);
+            for (const auto& name : deps->writes)
+            {
+                writers[name] = node;
+                readers.erase(name);
+            }
+            sinceBarrier.push_back(node);
+        }
+        pending++;
+        ready = node->waitingOn == 0;
+    }
+    if (ready)
+        schedule(std::move(node));
+}
+
+void DependencyGraph::schedule(NodePtr node)
+{
+    pool.submit([this, node]()
+    {
+        node->job();
+        node->job = nullptr; // let go of whatever the job holds before the dependents run
+        finish(node);
+    });
+}
+
+void DependencyGraph::finish(const NodePtr& node)
+{
+    std::vector<NodePtr> ready;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        node->done = true;
+        if (--pending == 0)
+            idle.notify_all();
+        for (auto& dependent : node->dependents)
+            if (--dependent->waitingOn == 0)
+                ready.push_back(std::move(dependent));
+        node->dependents.clear();
+
+        if (node->isBarrier)
+        {
+            if (barrier == node) barrier.reset();
+        }
+        else
+        {
+            for (const auto& name : node->uses.writes)
+            {
+                auto w = writers.find(name);
+                if (w != writers.end() && w->second == node) writers.erase(w);
+            }
+            for (const auto& name : node->uses.reads)
+            {
+                auto r = readers.find(name);
+                if (r == readers.end()) continue;
+                auto& list = r->second;
+                list.erase(std::remove(list.begin(), list.end(), node), list.end());
+                if (list.empty()) readers.erase(r);
+            }
+            sinceBarrier.erase(std::remove(sinceBarrier.begin(), sinceBarrier.end(), node), sinceBarrier.end());
+        }
+    }
+    for (auto& next : ready)
+        schedule(std::move(next));
+}
+
+size_t DependencyGraph::inFlight() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return pending;
+}
+
+void DependencyGraph::waitIdle()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [this]() { return pending == 0; });
+}
+
+}; // namespace render
+
+}; // namespace sword
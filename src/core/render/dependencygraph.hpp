@@ -1,17 +1,72 @@
 #ifndef RENDER_DEPENDENCYGRAPH_HPP
 #define RENDER_DEPENDENCYGRAPH_HPP
 
+//imp: render/dependencygraph.cpp
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace sword
 {
 
+namespace util { class ThreadPool; }
+
 namespace render
 {
 
+// renderer objects a job touches, by name. the convention is "<kind>:<name>",
+// e.g. "frag:spot" or "pipeline:brush".
+struct Dependencies
+{
+    std::vector<std::string> reads;
+    std::vector<std::string> writes;
+};
+
+// runs jobs on a thread pool while keeping submission order wherever two
+// jobs touch the same object and one of them writes it.
+// a job without dependencies is taken to touch everything: it waits for
+// everything before it and everything after waits for it.
 class DependencyGraph
 {
 public:
-    DependencyGraph(); 
+    using Job = std::function<void()>;
+
+    DependencyGraph(util::ThreadPool&);
+    void submit(const std::optional<Dependencies>&, Job);
+    size_t inFlight() const;
+    void waitIdle(); //until every job submitted so far has finished
+
 private:
+    struct Node
+    {
+        Job job;
+        Dependencies uses;
+        bool isBarrier{false};
+        int waitingOn{0};
+        bool done{false};
+        std::vector<std::shared_ptr<Node>> dependents;
+    };
+    using NodePtr = std::shared_ptr<Node>;
+
+    util::ThreadPool& pool;
+    mutable std::mutex lock;
+    std::condition_variable idle;
+
+    std::unordered_map<std::string, NodePtr> writers;
+    std::unordered_map<std::string, std::vector<NodePtr>> readers;
+    std::vector<NodePtr> sinceBarrier;
+    NodePtr barrier;
+    size_t pending{0};
+
+    void dependOn(const NodePtr& node, const NodePtr& on);
+    void schedule(NodePtr);
+    void finish(const NodePtr&);
 };
 
 }; // namespace render
@@ -2,11 +2,15 @@
 #include <render/context.hpp>
 #include <render/resource.hpp>
 #include <render/swapchain.hpp>
+#include <render/surface/window.hpp>
 #include <render/renderframe.hpp>
 #include <render/renderlayer.hpp>
 #include <render/attachment.hpp>
 #include <render/renderer.hpp>
 #include <util/debug.hpp>
+#include <util/defs.hpp>
+#include <util/profiler.hpp>
+#include <util/metrics.hpp>
 
 namespace sword
 {
@@ -25,7 +29,8 @@ Renderer::Renderer(Context& context) :
         device, 
         graphicsQueue, 
         context.getGraphicsQueueFamilyIndex(), 
-        vk::CommandPoolCreateFlagBits::eTransient}
+        vk::CommandPoolCreateFlagBits::eTransient},
+    shaderBundle{SHADER_BUNDLE}
 {
     createDescriptorPool();
     createHostBuffer(defaultBufferSize); //arbitrary for now. 100MB
@@ -39,7 +44,14 @@ Renderer::~Renderer()
 
 void Renderer::prepareRenderFrames(Window& window)
 {
+    if (window.isHeadless())
+    {
+        prepareHeadlessFrames(window);
+        return;
+    }
 	swapchain = std::make_unique<Swapchain>(context, window, swapchainImageCount); 
+    swapFormat = swapchain->getFormat();
+    swapExtent = swapchain->getExtent2D();
     auto& swapchainImages = swapchain->getImages();
 	for (auto& imageHandle : swapchainImages) 
 	{
@@ -58,6 +70,26 @@ void Renderer::prepareRenderFrames(Window& window)
 	}
 }
 
+// same number of frames as with a swapchain, each drawing into an image we own.
+// nothing is presented, frames just take turns
+void Renderer::prepareHeadlessFrames(Window& window)
+{
+    swapExtent = vk::Extent2D{window.getWidth(), window.getHeight()};
+    for (int i = 0; i < swapchainImageCount; i++) 
+    {
+        auto target = std::make_unique<Attachment>(
+                device, 
+                swapExtent, 
+                vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc);
+        swapFormat = target->getFormat();
+        frames.emplace_back(RenderFrame(
+                context, 
+                std::move(target), 
+                swapExtent.width, 
+                swapExtent.height));
+    }
+}
+
 RenderPass& Renderer::createRenderPass(std::string name)
 {
 	auto renderPass{RenderPass(device, name)};
@@ -213,7 +245,7 @@ void Renderer::prepareAsSwapchainPass(RenderPass& rpSwap)
     vk::ClearColorValue cv;
     cv.setFloat32({.0,.0,.0,0.});
 	rpSwap.createColorAttachment(
-			swapchain->getFormat(), 
+			swapFormat, 
 			vk::ImageLayout::eUndefined,
 			vk::ImageLayout::ePresentSrcKHR,
             cv,
@@ -261,9 +293,9 @@ Attachment& Renderer::createAttachment(
         const std::string name, const vk::Extent2D extent,
         const vk::ImageUsageFlags usageFlags)
 {
-    SWD_DEBUG_MSG("Context " << &context);
-    SWD_DEBUG_MSG("Context Device " << context.getDevice());
-    SWD_DEBUG_MSG("Device " << device);
+    SWD_TRACE_MSG("Context " << &context);
+    SWD_TRACE_MSG("Context Device " << context.getDevice());
+    SWD_TRACE_MSG("Device " << device);
     auto attachment = std::make_unique<Attachment>(device, extent, usageFlags);
     attachments.emplace(name, std::move(attachment));
     return *attachments.at(name);
@@ -279,10 +311,11 @@ bool Renderer::createGraphicsPipeline(
 		const geo::VertexInfo* vertInfo,
         const vk::PolygonMode polygonMode)
 {
+    std::shared_lock<std::shared_mutex> readGuard(objectLock);
     if (graphicsPipelines.find(name) == graphicsPipelines.end())
     {
         std::vector<const Shader*> shaderPointers = 
-            {&vertexShaders.at(vertShader), &fragShaderAt(fragShader)};
+            {&vertexShaders.at(vertShader), &fragmentShaders.at(fragShader)};
 
         const vk::PipelineLayout& layout = *pipelineLayouts.at(pipelineLayout);
 
@@ -302,7 +335,7 @@ bool Renderer::createGraphicsPipeline(
             vertexState.setVertexAttributeDescriptionCount(0);
         }
 
-        graphicsPipelines.emplace(name, GraphicsPipeline(
+        GraphicsPipeline pipeline(
                     name,
                     device,
                     layout,
@@ -311,8 +344,11 @@ bool Renderer::createGraphicsPipeline(
                     renderArea,
                     shaderPointers,
                     vertexState, 
-                    polygonMode));
+                    polygonMode);
 
+        readGuard.unlock();
+        std::unique_lock<std::shared_mutex> writeGuard(objectLock);
+        graphicsPipelines.emplace(name, std::move(pipeline));
         return true;
     }
     else
@@ -351,9 +387,58 @@ bool Renderer::recreateGraphicsPipeline(const std::string name)
     }
 }
 
+// a loose .spv written after the bundle was rebuilt since, by glslc or a rerun
+// of compileShaders.py, so it wins over the copy the bundle was mapped with
+std::optional<ShaderBundle::Blob> Renderer::bundledShader(const std::string& name, const std::string& loosePath) const
+{
+    auto blob = shaderBundle.find(name);
+    if (!blob)
+        return std::nullopt;
+    if (shaderBundle.isOlderThan(loosePath))
+        return std::nullopt;
+    return blob;
+}
+
+bool Renderer::loadVertShader(const std::string name)
+{
+    auto path = SHADER_DIR + std::string("/") + name;
+    auto blob = bundledShader(name, path);
+    if (!blob)
+        return loadVertShader(path, name);
+    std::unique_lock<std::shared_mutex> guard(objectLock);
+    if (vertexShaders.find(name) == vertexShaders.end())
+    {
+        vertexShaders.emplace(
+            std::piecewise_construct,
+            std::forward_as_tuple(name),
+            std::forward_as_tuple(device, blob->code, blob->size));
+        return true;
+    }
+    return false;
+}
+
+bool Renderer::loadFragShader(const std::string name)
+{
+    auto path = SHADER_DIR + std::string("/") + name;
+    auto blob = bundledShader(name, path);
+    if (!blob)
+        return loadFragShader(path, name);
+    std::unique_lock<std::shared_mutex> guard(objectLock);
+    if (fragmentShaders.find(name) == fragmentShaders.end())
+    {
+        fragmentShaders.emplace(
+            std::piecewise_construct,
+            std::forward_as_tuple(name),
+            std::forward_as_tuple(device, blob->code, blob->size));
+        return true;
+    }
+    return false;
+}
+
 bool Renderer::loadVertShader(
         const std::string path, const std::string name)
 {
+    std::unique_lock<std::shared_mutex> guard(objectLock);
     if (vertexShaders.find(name) == vertexShaders.end())
     {
         vertexShaders.emplace(
@@ -368,6 +453,7 @@ bool Renderer::loadVertShader(
 bool Renderer::loadVertShader(
         std::vector<uint32_t>&& code, const std::string name)
 {
+    std::unique_lock<std::shared_mutex> guard(objectLock);
     if (vertexShaders.find(name) == vertexShaders.end())
     {
         vertexShaders.emplace(
@@ -382,6 +468,7 @@ bool Renderer::loadVertShader(
 bool Renderer::loadFragShader(
 		const std::string path, const std::string name)
 {
+    std::unique_lock<std::shared_mutex> guard(objectLock);
     if (fragmentShaders.find(name) == fragmentShaders.end())
     {
         fragmentShaders.emplace(
@@ -396,6 +483,7 @@ bool Renderer::loadFragShader(
 bool Renderer::loadFragShader(
         std::vector<uint32_t>&& code, const std::string name)
 {
+    std::unique_lock<std::shared_mutex> guard(objectLock);
     if (fragmentShaders.find(name) == fragmentShaders.end())
     {
         fragmentShaders.emplace(
@@ -481,8 +569,9 @@ void Renderer::clearRenderLayers()
     }
 }
 
-void Renderer::render(uint32_t cmdId, int count, const std::array<int, 5>& ubosToUpdate)
+bool Renderer::render(uint32_t cmdId, int count, const std::array<int, 5>& ubosToUpdate)
 {
+    SWD_PROFILE_SCOPE("Renderer::render");
 	auto& renderBuffer = beginFrame(cmdId);
 	assert(renderBuffer.isRecorded() && "Render buffer is not recorded");
 
@@ -494,6 +583,11 @@ void Renderer::render(uint32_t cmdId, int count, const std::array<int, 5>& ubosT
     }
 
 	//renderBuffer.waitForFence();
+    if (!swapchain)
+    {
+        renderBuffer.submit(); //headless, nothing to wait for or present
+        return false;
+    }
 	auto submissionCompleteSemaphore = renderBuffer.submit(
 			imageAcquiredSemaphore, 
 			vk::PipelineStageFlagBits::eColorAttachmentOutput);
@@ -506,6 +600,18 @@ void Renderer::render(uint32_t cmdId, int count, const std::array<int, 5>& ubosT
 	pi.setWaitSemaphoreCount(1);
 
 	graphicsQueue.presentKHR(pi);
+    return true;
+}
+
+// presentKHR returning means the image is queued for the display, which is as
+// close to the screen as we can see from here
+void Renderer::render(const RenderParms& parms)
+{
+    if (!render(parms.getBufferId(), parms.getUboCount(), parms.getUboIndices()))
+        return;
+    auto presented = std::chrono::steady_clock::now();
+    for (auto& stamp : parms.inputs) 
+        stamp.latency->record(util::metrics::toMicros(presented - stamp.time));
 }
 
 void Renderer::bindUboData(void* dataPointer, uint32_t size, uint32_t index)
@@ -516,6 +622,11 @@ void Renderer::bindUboData(void* dataPointer, uint32_t size, uint32_t index)
 
 CommandBuffer& Renderer::beginFrame(uint32_t cmdId)
 {
+    if (!swapchain)
+    {
+        activeFrameIndex = (activeFrameIndex + 1) % frames.size();
+        return frames.at(activeFrameIndex).getRenderBuffer(cmdId);
+    }
 	//to do: look into storing the imageAcquiredSemaphore in the command buffer itself
 	auto& prevFrame = frames.at(activeFrameIndex);
 	imageAcquiredSemaphore = prevFrame.requestSemaphore();
@@ -679,18 +790,20 @@ void Renderer::listRenderPasses() const
 
 FragShader& Renderer::fragShaderAt(const std::string name)
 {
+    std::shared_lock<std::shared_mutex> guard(objectLock);
     return fragmentShaders.at(name);
 }
 
 VertShader& Renderer::vertShaderAt(const std::string name)
 {
+    std::shared_lock<std::shared_mutex> guard(objectLock);
     return vertexShaders.at(name);
 }
 
 
 BufferBlock* Renderer::copySwapToHost()
 {
-    auto extent = swapchain->getExtent2D();
+    auto extent = swapExtent;
     auto block = hostBuffer->requestBlock(
             extent.width * extent.height * 4);
 
@@ -780,7 +893,17 @@ BufferBlock* Renderer::copyAttachmentToHost(
 
     commandBuffer.copyImageToBuffer(image, hostBuffer->getHandle(), copyRegion);
 
-    commandBuffer.end(); //renderpass should take care of converting the swap image layout back for us
+    //the attachment may get sampled before anything renders to it again
+    imb.setOldLayout(vk::ImageLayout::eTransferSrcOptimal);
+    imb.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    imb.setSrcAccessMask(vk::AccessFlagBits::eTransferRead);
+    imb.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    commandBuffer.insertImageMemoryBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eFragmentShader,
+            imb);
+
+    commandBuffer.end();
 
     commandBuffer.submit();
 
@@ -806,6 +929,7 @@ void Renderer::copyHostToAttachment(void* source, int size, std::string attachme
     assert(size == region.extent.width * region.extent.height * 4 && "size does not match region");
 
     auto block = hostBuffer->requestBlock(size);
+    memcpy(block->pHostMemory, source, size);
 
     auto& commandBuffer = commandPool.requestCommandBuffer();
 
@@ -824,7 +948,7 @@ void Renderer::copyHostToAttachment(void* source, int size, std::string attachme
     imb.setOldLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
     imb.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
     imb.setSrcAccessMask(vk::AccessFlagBits::eMemoryRead);
-    imb.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+    imb.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
     imb.setSubresourceRange(isr);
 
     commandBuffer.begin();
@@ -841,7 +965,26 @@ void Renderer::copyHostToAttachment(void* source, int size, std::string attachme
     copyRegion.setBufferRowLength(0);
     copyRegion.setBufferImageHeight(0);
 
-    //TODO: finish this
+    commandBuffer.copyBufferToImage(hostBuffer->getHandle(), image, copyRegion);
+
+    //back to where the samplers expect it
+    imb.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+    imb.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    imb.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    imb.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    commandBuffer.insertImageMemoryBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eFragmentShader,
+            imb);
+
+    commandBuffer.end();
+
+    commandBuffer.submit();
+
+    commandBuffer.waitForFence();
+
+    commandPool.resetPool();
+    hostBuffer->popBackBlock();
 }
 
 Attachment* Renderer::getAttachmentPtr(std::string name) const
@@ -851,7 +994,7 @@ Attachment* Renderer::getAttachmentPtr(std::string name) const
 
 vk::Extent2D Renderer::getSwapExtent()
 {
-    return swapchain->getExtent2D();
+    return swapExtent;
 }
 
 
@@ -5,9 +5,12 @@
 #include <memory>
 #include <tuple>
 #include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
 #include <functional>
 #include <render/command.hpp>
 #include <render/shader.hpp>
+#include <render/shaderbundle.hpp>
 #include <render/pipeline.hpp>
 #include <render/renderpass.hpp>
 #include <geometry/types.hpp>
@@ -47,6 +50,9 @@ public:
     Renderer& operator=(Renderer&) = delete;
     Renderer& operator=(Renderer&&) = delete;
     Renderer(Renderer&&) = delete;
+    // by name from the shader bundle, or from the loose file in SHADER_DIR if it isn't there
+    bool loadFragShader(const std::string name);
+    bool loadVertShader(const std::string name);
     bool loadFragShader(const std::string path, const std::string name);
     bool loadFragShader(std::vector<uint32_t>&& code, const std::string name);
     bool loadVertShader(const std::string path, const std::string name);
@@ -91,7 +97,8 @@ public:
         const std::string attachment, const std::string renderpass,
         const std::string pipeline, const DrawParms);
     void clearRenderLayers();
-    void render(uint32_t cmdId, int count, const std::array<int, 5>& ubosToUpdate); //5 is the max number of ubos we can have
+    bool render(uint32_t cmdId, int count, const std::array<int, 5>& ubosToUpdate); //5 is the max number of ubos we can have. false if nothing was presented
+    void render(const RenderParms&); //also records how long the parms' inputs took to reach present
     void popBufferBlock();
     void listAttachments() const;
     void listVertShaders() const;
@@ -123,7 +130,9 @@ private:
     const vk::Device& device;
     const vk::Queue graphicsQueue;
     std::vector<RenderFrame> frames;
-    std::unique_ptr<Swapchain> swapchain;
+    std::unique_ptr<Swapchain> swapchain; //null when headless
+    vk::Format swapFormat{vk::Format::eUndefined};
+    vk::Extent2D swapExtent;
     bool descriptionIsBound;
     uint32_t renderPassCount{0};
     Attachment* activeTarget;
@@ -149,6 +158,10 @@ private:
     uint32_t activeFrameIndex{0};
 
     std::unordered_map<std::string, std::unique_ptr<Attachment>> attachments;
+    // shader and pipeline commands may run side by side, so these maps need guarding
+    mutable std::shared_mutex objectLock;
+    ShaderBundle shaderBundle;
+    std::optional<ShaderBundle::Blob> bundledShader(const std::string& name, const std::string& loosePath) const;
     std::unordered_map<std::string, VertShader> vertexShaders;
     std::unordered_map<std::string, FragShader> fragmentShaders;
     std::unordered_map<std::string, vk::UniqueDescriptorSetLayout> descriptorSetLayouts;
@@ -158,6 +171,7 @@ private:
     void createDefaultDescriptorSetLayout(const std::string name);
 
     CommandBuffer& beginFrame(uint32_t cmdId);
+    void prepareHeadlessFrames(Window& window);
 
     void createDescriptorPool();
     void updateFrameDescriptorBuffer(uint32_t frame, uint32_t uboIndex);
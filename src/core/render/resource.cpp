@@ -2,6 +2,8 @@
 #include <iostream>
 #include <render/resource.hpp>
 #include <render/types.hpp>
+#include <util/metrics.hpp>
+#include <util/debug.hpp>
 
 namespace sword
 {
@@ -9,6 +11,13 @@ namespace sword
 namespace render
 {
 
+// block bytes handed out across every buffer
+static util::metrics::Gauge& bytesInUse()
+{
+    static auto& gauge = util::metrics::registry().gauge("render.bufferBytes");
+    return gauge;
+}
+
 uint32_t findMemoryType(
 		vk::MemoryRequirements memReqs,  //returned by device.getBufferMemoryRequirements()
 		vk::MemoryPropertyFlags properties,
@@ -41,12 +50,12 @@ Buffer::Buffer(
 {
 	handle = device.createBufferUnique({{}, size, usage, vk::SharingMode::eExclusive, {}, {}});
     allocateAndBindMemory();
-	std::cout << "Created buffer!" << '\n';
-	std::cout << "Buffer size: " << size << '\n';
+    SWD_DEBUG_MSG("Created buffer. Size: " << size);
 }
 
 Buffer::~Buffer()
 {
+    bytesInUse().add(-int64_t(curBlockOffset));
     if (isMapped) 
     {
         device.unmapMemory(*memory); 
@@ -69,7 +78,7 @@ BufferBlock* Buffer::requestBlock(uint32_t blockSize)
 {
     uint32_t allocSize{0};
     uint32_t minAlignment = devProps.limits.minUniformBufferOffsetAlignment;
-    std::cout << "min alignment " << minAlignment << std::endl;
+    SWD_TRACE_MSG("min alignment " << minAlignment);
     if (blockSize % minAlignment == 0) //is aligned
         allocSize = blockSize;
     else 
@@ -88,22 +97,23 @@ BufferBlock* Buffer::requestBlock(uint32_t blockSize)
     {
         block->pHostMemory = static_cast<uint8_t*>(pHostMemory) + block->offset;
         block->isMapped = true;
-        std::cout << "Block hostmem: " << block->pHostMemory << std::endl;
-        std::cout << "===!+!+!+!+!+!+!+!+!+!+!+!++!+!+!+!+++===" << std::endl;
+        SWD_TRACE_MSG("Block hostmem: " << block->pHostMemory);
     }
     bufferBlocks.push_back(std::move(block));
-    std::cout << " Block made" <<
+    SWD_DEBUG_MSG("Block made" <<
        " curBlockOffset: " << curBlockOffset <<
-       " blockSize: " << blockSize << std::endl;
+       " blockSize: " << blockSize);
     curBlockOffset += allocSize;
+    bytesInUse().add(allocSize);
     return bufferBlocks.back().get();
 }
 
 void Buffer::popBackBlock()
 {
     curBlockOffset -= bufferBlocks.back()->allocSize;
+    bytesInUse().add(-int64_t(bufferBlocks.back()->allocSize));
     bufferBlocks.pop_back();
-    std::cout << "Block popped. " << bufferBlocks.size() << " remain." << std::endl;
+    SWD_DEBUG_MSG("Block popped. " << bufferBlocks.size() << " remain.");
 }
 
 void Buffer::map()
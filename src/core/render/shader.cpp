@@ -28,6 +28,18 @@ Shader::Shader(const vk::Device& device, std::vector<uint32_t>&& code) :
 	std::cout << "Shader constructed" << '\n';
 }
 
+// vulkan copies the code while making the module, so this can point
+// straight into a mapped bundle
+Shader::Shader(const vk::Device& device, const uint32_t* code, size_t codeSize) :
+    device{device}, codeSize{codeSize}
+{
+	vk::ShaderModuleCreateInfo ci;
+	ci.setPCode(code);
+	ci.setCodeSize(codeSize);
+	module = device.createShaderModuleUnique(ci);
+    initialize();
+}
+
 //Shader::~Shader()
 //{
 //	if (module)
@@ -140,6 +152,12 @@ VertShader::VertShader(const vk::Device& device, std::vector<uint32_t>&& code) :
 	stageInfo.setStage(vk::ShaderStageFlagBits::eVertex);
 }
 
+VertShader::VertShader(const vk::Device& device, const uint32_t* code, size_t codeSize) :
+	Shader(device, code, codeSize)
+{
+	stageInfo.setStage(vk::ShaderStageFlagBits::eVertex);
+}
+
 FragShader::FragShader(const vk::Device& device, std::string filepath) :
 	Shader(device, filepath)
 {
@@ -152,6 +170,12 @@ FragShader::FragShader(const vk::Device& device, std::vector<uint32_t>&& code) :
 	stageInfo.setStage(vk::ShaderStageFlagBits::eFragment);
 }
 
+FragShader::FragShader(const vk::Device& device, const uint32_t* code, size_t codeSize) :
+	Shader(device, code, codeSize)
+{
+	stageInfo.setStage(vk::ShaderStageFlagBits::eFragment);
+}
+
 }; // namespace render
 
 }; // namespace sword
@@ -38,6 +38,7 @@ public:
 protected:
     Shader(const vk::Device&, std::string filepath);
     Shader(const vk::Device&, std::vector<uint32_t>&& code);
+    Shader(const vk::Device&, const uint32_t* code, size_t codeSize); //code need only outlive the constructor
     vk::PipelineShaderStageCreateInfo stageInfo;
     std::vector<vk::SpecializationMapEntry> mapEntries;
     vk::SpecializationInfo specInfo;
@@ -58,6 +59,7 @@ class VertShader : public Shader
 public:
     VertShader(const vk::Device&, std::string);
     VertShader(const vk::Device&, std::vector<uint32_t>&& code);
+    VertShader(const vk::Device&, const uint32_t* code, size_t codeSize);
 };
 
 class FragShader : public Shader
@@ -65,6 +67,7 @@ class FragShader : public Shader
 public:
     FragShader(const vk::Device&, std::string);
     FragShader(const vk::Device&, std::vector<uint32_t>&& code);
+    FragShader(const vk::Device&, const uint32_t* code, size_t codeSize);
 };
 
 
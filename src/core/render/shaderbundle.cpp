@@ -0,0 +1,90 @@
+#include "shaderbundle.hpp"
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sword
+{
+
+namespace render
+{
+
+ShaderBundle::ShaderBundle(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        std::cerr << "ShaderBundle: no bundle at " << path << ", shaders load from loose files" << '\n';
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        mappingSize = st.st_size;
+        modified = st.st_mtim; //of the file we map, even if it is replaced before we are done
+        mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+            mapping = nullptr;
+    }
+    close(fd);
+    if (!mapping || !index())
+    {
+        std::cerr << "ShaderBundle: " << path << " is not a shader bundle" << '\n';
+        blobs.clear();
+    }
+}
+
+ShaderBundle::~ShaderBundle()
+{
+    if (mapping)
+        munmap(mapping, mappingSize);
+}
+
+bool ShaderBundle::isOlderThan(const std::string& path) const
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    if (st.st_mtim.tv_sec != modified.tv_sec)
+        return st.st_mtim.tv_sec > modified.tv_sec;
+    return st.st_mtim.tv_nsec > modified.tv_nsec;
+}
+
+// checks every entry lies inside the file before anything is handed out
+bool ShaderBundle::index()
+{
+    auto base = static_cast<const char*>(mapping);
+    auto words = static_cast<const uint32_t*>(mapping);
+    if (mappingSize < 4 * sizeof(uint32_t) || words[0] != magic || words[1] != version)
+        return false;
+    size_t count = words[2];
+    if (count > (mappingSize / sizeof(uint32_t) - 4) / 4)
+        return false;
+    auto entries = words + 4;
+    for (size_t i = 0; i < count; i++) 
+    {
+        auto entry = entries + i * 4;
+        size_t nameOffset = entry[0], nameLength = entry[1], codeOffset = entry[2], codeSize = entry[3];
+        if (nameOffset + nameLength > mappingSize || codeOffset + codeSize > mappingSize)
+            return false;
+        if (codeOffset % sizeof(uint32_t) || codeSize % sizeof(uint32_t) || codeSize == 0)
+            return false;
+        blobs[std::string_view(base + nameOffset, nameLength)] = 
+            {reinterpret_cast<const uint32_t*>(base + codeOffset), codeSize};
+    }
+    return true;
+}
+
+std::optional<ShaderBundle::Blob> ShaderBundle::find(std::string_view name) const
+{
+    auto it = blobs.find(name);
+    if (it == blobs.end())
+        return std::nullopt;
+    return it->second;
+}
+
+}; // namespace render
+
+}; // namespace sword
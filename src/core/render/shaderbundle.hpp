@@ -0,0 +1,61 @@
+#ifndef RENDER_SHADERBUNDLE_HPP
+#define RENDER_SHADERBUNDLE_HPP
+
+//imp: render/shaderbundle.cpp
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace sword
+{
+
+namespace render
+{
+
+// every precompiled shader in one file, written by tools/compileShaders.py and
+// mapped read only for as long as we live. the layout, all little endian:
+//   header   magic "SWSB", version, entry count, reserved    4 x uint32
+//   entries  name offset, name length, code offset, code size 4 x uint32 each
+//   names    the entry names, not terminated
+//   code     each blob 4 byte aligned, so it can go to vulkan as is
+// offsets are from the start of the file and sizes are in bytes.
+// names are the .spv file names the loose files had, e.g. "simple.spv"
+class ShaderBundle
+{
+public:
+    struct Blob
+    {
+        const uint32_t* code;
+        size_t size; //bytes
+    };
+
+    explicit ShaderBundle(const std::string& path);
+    ~ShaderBundle();
+    ShaderBundle(const ShaderBundle&) = delete;
+    ShaderBundle& operator=(const ShaderBundle&) = delete;
+
+    std::optional<Blob> find(std::string_view name) const;
+    size_t size() const { return blobs.size(); }
+    bool isOlderThan(const std::string& path) const; //than the file at path, if there is one
+
+    static constexpr uint32_t magic = 0x42535753; //"SWSB"
+    static constexpr uint32_t version = 1;
+private:
+    bool index();
+
+    void* mapping{nullptr};
+    size_t mappingSize{0};
+    timespec modified{}; //when the mapped file was written
+    std::unordered_map<std::string_view, Blob> blobs; //names point into the mapping
+};
+
+}; // namespace render
+
+}; // namespace sword
+
+#endif /* end of include guard: RENDER_SHADERBUNDLE_HPP */
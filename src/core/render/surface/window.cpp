@@ -7,11 +7,17 @@ namespace sword
 namespace render
 {
 
-Window::Window(uint16_t width, uint16_t height) :
-	connection{xcb_connect(NULL,NULL)},
-    window{xcb_generate_id(connection)},
-    width{width}, height{height}
+Window::Window(uint16_t width, uint16_t height, bool headless) :
+	connection{headless ? nullptr : xcb_connect(NULL,NULL)},
+    window{headless ? 0 : xcb_generate_id(connection)},
+    width{width}, height{height}, headless{headless}
 {
+    if (headless)
+    {
+        size.push_back(width);
+        size.push_back(height);
+        return;
+    }
 	screen = xcb_setup_roots_iterator(
 			xcb_get_setup(connection)).data;
 	setEvents();
@@ -90,16 +96,23 @@ void Window::setClass()
 
 xcb_generic_event_t* Window::pollEvents() const
 {
+    if (headless) return nullptr;
 	return xcb_poll_for_event(connection);
 }
 
 xcb_generic_event_t* Window::waitForEvent() const
 {
+    if (headless) return nullptr;
 	return xcb_wait_for_event(connection);
 }
 
 void Window::open()
 {
+    if (headless)
+    {
+        opened = true;
+        return;
+    }
 	xcb_map_window(connection, window);
 	xcb_flush(connection);
     opened = true;
@@ -14,7 +14,7 @@ namespace render
 class Window
 {
 public:
-	Window (uint16_t width, uint16_t height);
+	Window (uint16_t width, uint16_t height, bool headless = false);
 
     ~Window();
 
@@ -28,6 +28,10 @@ public:
 
     bool isOpen() {return opened;}
 
+    // a headless window never talks to the X server. it has a size and
+    // nothing else, and the renderer draws into plain images instead of a swapchain
+    bool isHeadless() const {return headless;}
+
 	std::vector<int> size;
 	
 	xcb_generic_event_t* pollEvents() const;
@@ -50,6 +54,7 @@ private:
     std::string appClass = "floating";
     bool created{false};
     bool opened{false};
+    bool headless{false};
 
 	void createWindow(const int width, const int height);
 
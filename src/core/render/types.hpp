@@ -3,10 +3,15 @@
 
 #include <types/vktypes.hpp>
 #include <util/debug.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
 
 namespace sword
 {
 
+namespace util { namespace metrics { class Histogram; }; };
+
 namespace render
 {
 
@@ -41,6 +46,40 @@ private:
     uint32_t firstVertex{0};
 };
 
+// the oldest input of each kind that a frame answers, so the renderer can
+// time input to present. each kind has its own histogram to record into
+class InputStamps
+{
+public:
+    static constexpr size_t MAX_KINDS = 8;
+    struct Stamp
+    {
+        util::metrics::Histogram* latency;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    // a later input of a kind we already have is answered by the same frame, so
+    // only the earlier one is kept. kinds past MAX_KINDS are ignored
+    void add(util::metrics::Histogram* latency, std::chrono::steady_clock::time_point time)
+    {
+        for (size_t i = 0; i < count; i++) 
+            if (stamps[i].latency == latency)
+            {
+                stamps[i].time = std::min(stamps[i].time, time);
+                return;
+            }
+        if (count < MAX_KINDS)
+            stamps[count++] = {latency, time};
+    }
+    void clear() { count = 0; }
+    bool empty() const { return count == 0; }
+    const Stamp* begin() const { return stamps.data(); }
+    const Stamp* end() const { return stamps.data() + count; }
+private:
+    std::array<Stamp, MAX_KINDS> stamps;
+    size_t count{0};
+};
+
 struct RenderParms
 {
     static constexpr int MAX_UBO_COUNT = 5;
@@ -62,6 +101,7 @@ struct RenderParms
     constexpr uint32_t getUboCount() const { return uboCount; }
     const std::array<int, MAX_UBO_COUNT>& getUboIndices() const { return uboIndices; } 
     size_t uboCount{0};
+    InputStamps inputs; //filled in by whoever hands these to the renderer
 private:
     uint32_t bufferId{0};
     std::array<int, MAX_UBO_COUNT> uboIndices;
@@ -22,11 +22,10 @@ void CreateFrameDescriptorSets::handleEvent(event::Event* event)
 {
     if (event->getCategory() == event::Category::CommandLine)
     {
-        auto stream = toCommandLine(event)->getStream();
+        auto ce = toCommandLine(event);
         std::vector<std::string> layoutNames;
-        std::string name;
-        while (stream >> name)
-            layoutNames.push_back(name);
+        for (size_t i = 0; i < ce->getWordCount(); i++) 
+            layoutNames.emplace_back(ce->getWord(i));
         auto cmd = cfdsPool.request(reportCallback(), layoutNames);
         pushCmd(std::move(cmd));
         event->setHandled();
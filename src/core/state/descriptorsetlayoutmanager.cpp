@@ -26,8 +26,7 @@ void SetDescriptorType::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::CommandLine)
     {
         auto ce = toCommandLine(event);
-        auto input = ce->getFirstWord();
-        auto option = options.findValue(input);
+        auto option = options.findValue(ce->getWord(0));
         if (option)
         {
             assert(binding);
@@ -53,9 +52,8 @@ void SetDescriptorCount::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::CommandLine)
     {
         auto ce = toCommandLine(event);
-        auto stream = ce->getStream();
-        int i;
-        stream >> i;
+        int i{0};
+        ce->get(0, i);
         assert( i > 0 );
         binding->setDescriptorCount(i);
         event->setHandled();
@@ -82,8 +80,7 @@ void SetShaderStageEntry::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::CommandLine)
     {
         auto ce = toCommandLine(event);
-        auto input = ce->getFirstWord();
-        auto option = options.findValue(input);
+        auto option = options.findValue(ce->getWord(0));
         if (option)
         {
             std::cout << "Got option" << std::endl;
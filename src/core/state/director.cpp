@@ -1,6 +1,8 @@
 #include <state/director.hpp>
 #include <event/event.hpp>
 #include <util/stringutil.hpp>
+#include <util/profiler.hpp>
+#include <util/metrics.hpp>
 #include <thread>
 
 namespace sword
@@ -44,7 +46,9 @@ Director::Director(StateArgs sa, const StateStack& ss, render::Window& window) :
         {"quick_setup", opcast(Op::quickSetup)},
         {"quick_setup3", opcast(Op::quickSetup3)},
         {"painter", opcast(Op::painter)},
-        {"viewer", opcast(Op::viewer)}
+        {"viewer", opcast(Op::viewer)},
+        {"profile", opcast(Op::profile)},
+        {"stats", opcast(Op::stats)}
     }}, 
     stateStack{ss},
     renderManager{sa, 
@@ -63,6 +67,13 @@ Director::Director(StateArgs sa, const StateStack& ss, render::Window& window) :
     activate(opcast(Op::quickSetup3));
     activate(opcast(Op::painter));
     activate(opcast(Op::viewer));
+    activate(opcast(Op::profile));
+    activate(opcast(Op::stats));
+}
+
+event::Routes Director::getRoutes() const
+{
+    return {event::Category::CommandLine, event::Category::Abort};
 }
 
 void Director::handleEvent(event::Event* event)
@@ -79,6 +90,8 @@ void Director::handleEvent(event::Event* event)
             case Op::quickSetup: quickSetup(); break;
             case Op::quickSetup3: quickSetup3(); break;
             case Op::viewer: pushState(&viewer); deactivate(opcast(Op::viewer)); break;
+            case Op::profile: profile(toCommandLine(event)); break;
+            case Op::stats: stats(toCommandLine(event)); break;
         }
         event->setHandled();
     }
@@ -94,6 +107,53 @@ void Director::printStateHierarchy()
     stateStack.print();
 }
 
+// profile dump <file>
+void Director::profile(event::CommandLine* ce)
+{
+    auto verb = ce->getArg<std::string, 1>();
+    auto file = ce->getArg<std::string, 2>();
+    if (verb != "dump" || file.empty())
+    {
+        std::cout << "Usage: profile dump <file>" << '\n';
+        return;
+    }
+#ifdef SWD_PROFILE
+    if (util::profiler::dumpChromeTrace(file))
+        std::cout << "Wrote trace to " << file << '\n';
+    else
+        std::cerr << "Director::profile: could not write " << file << '\n';
+#else
+    std::cout << "Built without SWD_PROFILE, nothing to dump." << '\n';
+#endif
+}
+
+// stats
+// stats record <file> [period ms]
+// stats stop
+void Director::stats(event::CommandLine* ce)
+{
+    auto& registry = util::metrics::registry();
+    auto verb = ce->getArg<std::string, 1>();
+    if (verb.empty())
+        registry.print(std::cout);
+    else if (verb == "record")
+    {
+        auto file = ce->getArg<std::string, 2>();
+        auto period = ce->getArg<int, 3>();
+        if (period <= 0) period = 1000;
+        if (file.empty())
+            std::cout << "Usage: stats record <file> [period ms]" << '\n';
+        else if (registry.startRecording(file, std::chrono::milliseconds(period)))
+            std::cout << "Recording stats to " << file << " every " << period << "ms" << '\n';
+        else
+            std::cerr << "Director::stats: could not open " << file << '\n';
+    }
+    else if (verb == "stop")
+        registry.stopRecording();
+    else
+        std::cout << "Usage: stats [record <file> [period ms] | stop]" << '\n';
+}
+
 void Director::pushRenderManager()
 {
     pushState(&renderManager);
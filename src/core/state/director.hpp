@@ -34,16 +34,19 @@ class Director final : public BranchState
 public:
     const char* getName() const override { return "director"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
     Director(StateArgs, const StateStack& ss, render::Window& window);
 
 private:
-    enum class Op : Option {viewer, painter, pushRenderManager, printHierarchy, quickSetup, quickSetup3};
+    enum class Op : Option {viewer, painter, pushRenderManager, printHierarchy, quickSetup, quickSetup3, profile, stats};
 
     void pushRenderManager();
     void printStateHierarchy();
     void popTop();
     void quickSetup();
     void quickSetup3();
+    void profile(event::CommandLine*);
+    void stats(event::CommandLine*);
 
     RenderManager renderManager;
     QuickSetup quickState;
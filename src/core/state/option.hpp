@@ -3,6 +3,7 @@
 
 #include <bitset>
 #include <functional>
+#include <optional>
 
 namespace sword
 {
@@ -1,5 +1,7 @@
 #include "painter.hpp"
 #include "event/event.hpp"
+#include "event/types.hpp"
+#include "event/checkpoint.hpp"
 #include "rendermanager.hpp"
 #include "vulkan/vulkan.hpp"
 #include <util/debug.hpp>
@@ -29,6 +31,8 @@ enum class Input : uint8_t
 
 constexpr Input inputCast(event::symbol::Key key) { return static_cast<Input>(key); }
 constexpr Input inputCast(event::symbol::MouseButton button) { return static_cast<Input>(button); }
+constexpr event::Route route(event::WindowEventType type, Input input) { return {type, static_cast<event::symbol::Key>(input)}; }
+constexpr event::Route buttonRoute(event::WindowEventType type, Input input) { return {type, static_cast<event::symbol::MouseButton>(input)}; }
 constexpr event::Window* toWindowEvent(event::Event* event) { return static_cast<event::Window*>(event); }
 
 void updateXform(glm::mat4& xform, const Matrices& mats)
@@ -48,6 +52,11 @@ void Rotate::onEnterExt()
     scaleRotCache = vars.matrices.scaleRotate;
 }
 
+event::Routes Rotate::getRoutes() const
+{
+    return {event::WindowEventType::Motion, route(event::WindowEventType::Keyrelease, Input::rotate)};
+}
+
 void Rotate::handleEvent(event::Event *event)
 {
     if (event->getCategory() == event::Category::Window)
@@ -58,6 +67,7 @@ void Rotate::handleEvent(event::Event *event)
             angle = angleScale * (we->getX() / vars.swapWidthFloat - initX + we->getY() / vars.swapHeightFloat - initY);
             scaleRot = scaleRotCache * vars.matrices.translate * glm::rotate(glm::mat4(1.), angle, {0, 0, 1.}) * glm::inverse(vars.matrices.translate);
             updateXform(xform, vars.matrices);
+            requestRedraw();
             event->setHandled();
             return;
         }
@@ -86,6 +96,11 @@ void Scale::onEnterExt()
     scaleRotCache = vars.matrices.scaleRotate;
 }
 
+event::Routes Scale::getRoutes() const
+{
+    return {event::WindowEventType::Motion, event::WindowEventType::MouseRelease};
+}
+
 void Scale::handleEvent(event::Event *event)
 {
     if (event->getCategory() == event::Category::Window)
@@ -99,6 +114,7 @@ void Scale::handleEvent(event::Event *event)
             glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.), glm::vec3(scale, scale, 1.));
             scaleRot = scaleRotCache * vars.matrices.translate * scaleMatrix * glm::inverse(vars.matrices.translate);
             updateXform(xform, vars.matrices);
+            requestRedraw();
             event->setHandled();
             return;
         }
@@ -122,6 +138,11 @@ void Translate::onEnterExt()
     tranlatePrevious = vars.matrices.translate;
 }
 
+event::Routes Translate::getRoutes() const
+{
+    return {event::WindowEventType::Motion, event::WindowEventType::MouseRelease};
+}
+
 void Translate::handleEvent(event::Event *event)
 {
     if (event->getCategory() == event::Category::Window)
@@ -131,14 +152,15 @@ void Translate::handleEvent(event::Event *event)
         {
             pos.x = we->getX() / vars.swapWidthFloat;
             pos.y = we->getY() / vars.swapHeightFloat;
-            SWD_DEBUG_MSG("pos.x: " << pos.x);
-            SWD_DEBUG_MSG("pos.y: " << pos.y);
+            SWD_TRACE_MSG("pos.x: " << pos.x);
+            SWD_TRACE_MSG("pos.y: " << pos.y);
             pos = pos - initPos;
             pos *= -1;
             translate = glm::translate(glm::mat4(1.), glm::vec3(pos.x, pos.y, 0)) * tranlatePrevious;
             updateXform(xform, vars.matrices);
-            SWD_DEBUG_MSG("xform: " << glm::to_string(vars.fragInput.xform));
-            SWD_DEBUG_MSG("viewCmd: " << vars.viewCmdId);
+            SWD_TRACE_MSG("xform: " << glm::to_string(vars.fragInput.xform));
+            SWD_TRACE_MSG("viewCmd: " << vars.viewCmdId);
+            requestRedraw();
             event->setHandled();
             return;
         }
@@ -178,6 +200,11 @@ void ResizeBrush::onExitExt()
     pushCmd(std::move(cmd));
 }
 
+event::Routes ResizeBrush::getRoutes() const
+{
+    return {event::WindowEventType::Motion, route(event::WindowEventType::Keyrelease, Input::resizeBrush), event::WindowEventType::LeaveWindow};
+}
+
 void ResizeBrush::handleEvent(event::Event* event)
 {
     if (event->getCategory() == event::Category::Window)
@@ -191,6 +218,7 @@ void ResizeBrush::handleEvent(event::Event* event)
             diff *= 20;
             brushSize = initBrushSize + diff;
 
+            requestRedraw();
             event->setHandled();
             return;
         }
@@ -236,63 +264,71 @@ void Paint::onExitExt()
     pushCmd(std::move(cmd));
 }
 
-void Paint::handleEvent(event::Event* event)
+void Paint::addSample(int16_t x, int16_t y)
 {
-    if (event->getCategory() == event::Category::Window)
-    {
-        auto we = static_cast<event::Window*>(event);
-        if (we->getType() == event::WindowEventType::Motion && mouseDown)
-        {
-            pos.x = we->getX() / vars.swapWidthFloat;
-            pos.y = we->getY() / vars.swapHeightFloat;
-            pos = vars.fragInput.xform * pos;
-            brushPosX = pos.x;
-            brushPosY = pos.y;
+    pos.x = x / vars.swapWidthFloat;
+    pos.y = y / vars.swapHeightFloat;
+    pos = vars.fragInput.xform * pos;
+    brushPosX = pos.x;
+    brushPosY = pos.y;
+
+    assert (paintSamples.count < maxPaintSamples);
+    paintSamples.samples[paintSamples.count] = {pos.x, pos.y};
+    paintSamples.count++;
+}
 
-            assert (paintSamples.count < maxPaintSamples);
-            paintSamples.samples[paintSamples.count] = {pos.x, pos.y};
-            paintSamples.count++;
+event::Routes Paint::getRoutes() const
+{
+    return {event::WindowEventType::Motion, buttonRoute(event::WindowEventType::MousePress, Input::paint), event::WindowEventType::MouseRelease, event::Category::Abort};
+}
 
+void Paint::handleEvent(event::Event* event)
+{
+    event::visit(*event, event::Overload{
+        [&](event::MouseMotion& motion)
+        {
+            if (!mouseDown)
+                return;
+            // the whole path, not just where the mouse ended up. if it is longer
+            // than the room left this frame it gets thinned out evenly, always
+            // keeping the last position
+            auto& path = motion.getPath();
+            size_t length = motion.getPathLength();
+            size_t room = maxPaintSamples - paintSamples.count;
+            size_t stride = room ? (length + room - 1) / room : length;
+            for (size_t i = (length - 1) % stride; room && i < length; i += stride) 
+                addSample(path[i].x, path[i].y);
+
+            requestRedraw();
             event->setHandled();
-            return;
-        }
-        if (we->getType() == event::WindowEventType::MousePress)
+        },
+        [&](event::MousePress& press)
         {
-            if (inputCast(static_cast<event::MousePress*>(we)->getMouseButton()) == Input::paint)
-            {
-                //copy image to undo image
-                auto copyCommand = copyAttachmentToImage.request("paint", &undoImage, vk::Rect2D({0, 0}, {C_WIDTH, C_HEIGHT}));
-
-                pos.x = we->getX() / vars.swapWidthFloat;
-                pos.y = we->getY() / vars.swapHeightFloat;
-                pos = vars.fragInput.xform * pos;
-                brushPosX = pos.x;
-                brushPosY = pos.y;
+            if (inputCast(press.getMouseButton()) != Input::paint)
+                return;
+            //copy image to undo image
+            auto copyCommand = copyAttachmentToImage.request("paint", &undoImage, vk::Rect2D({0, 0}, {C_WIDTH, C_HEIGHT}));
 
-                assert (paintSamples.count < maxPaintSamples);
-                paintSamples.samples[paintSamples.count] = {pos.x, pos.y};
-                paintSamples.count++;
+            if (paintSamples.count < maxPaintSamples)
+                addSample(press.getX(), press.getY());
 
-                pushCmd(std::move(copyCommand));
-                mouseDown = true;
-                event->setHandled();
-                return;
-            }
-        }
-        if (we->getType() == event::WindowEventType::MouseRelease)
+            pushCmd(std::move(copyCommand));
+            mouseDown = true;
+            requestRedraw();
+            event->setHandled();
+        },
+        [&](event::MouseRelease&)
         {
             mouseDown = false;
             event->setHandled();
-            return;
-        }
-    }
-    if (event->getCategory() == event::Category::Abort)
-    {
-        mouseDown = false;
-        popSelf();
-        event->setHandled();
-        return;
-    }
+        },
+        [&](event::Abort&)
+        {
+            mouseDown = false;
+            popSelf();
+            event->setHandled();
+        },
+        [](auto&) {}});
 }
 
 SaveAttachment::SaveAttachment(StateArgs sa, Callbacks cb) :
@@ -379,6 +415,14 @@ Painter::Painter(StateArgs sa, Callbacks cb) :
     updateXform(painterVars.fragInput.xform, painterVars.matrices);
 }
 
+event::Routes Painter::getRoutes() const
+{
+    return {event::Category::CommandLine,
+        route(event::WindowEventType::Keypress, Input::resizeBrush), route(event::WindowEventType::Keypress, Input::rotate), 
+        route(event::WindowEventType::Keypress, Input::copyImageToAttachment),
+        buttonRoute(event::WindowEventType::MousePress, Input::translate), buttonRoute(event::WindowEventType::MousePress, Input::scale)};
+}
+
 void Painter::handleEvent(event::Event* event)
 {
     if (event->getCategory() == event::Category::CommandLine)
@@ -537,6 +581,28 @@ void Painter::displayCanvas()
 void Painter::beginFrame()
 {
     painterVars.paintSamples.count = 0;
+    painterVars.fragInput.time = sessionTime();
+}
+
+// the canvas plus what the painter's leaves have done to the view and brush
+void Painter::saveCheckpoint(event::Checkpoint& checkpoint) const
+{
+    if (!initialized)
+        return;
+    checkpoint.put(painterVars.matrices);
+    checkpoint.put(painterVars.fragInput);
+    checkpoint.attachment = "paint";
+    checkpoint.width = C_WIDTH;
+    checkpoint.height = C_HEIGHT;
+}
+
+void Painter::restoreCheckpoint(event::Checkpoint& checkpoint)
+{
+    if (!initialized)
+        return;
+    if (!checkpoint.take(painterVars.matrices) || !checkpoint.take(painterVars.fragInput))
+        std::cerr << "Painter::restoreCheckpoint: checkpoint has no painter variables" << '\n';
+    requestRedraw();
 }
 
 void Painter::endFrame()
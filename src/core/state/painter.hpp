@@ -103,6 +103,7 @@ class Rotate : public LeafState
 public:
     const char* getName() const override { return "Rotate"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
     Rotate(StateArgs, Callbacks, PainterVars&);
 private:
     void onEnterExt() override;
@@ -120,6 +121,7 @@ class Scale : public LeafState
 public:
     const char* getName() const override { return "Scale"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
     Scale(StateArgs, Callbacks, PainterVars&);
 private:
     void onEnterExt() override;
@@ -135,6 +137,7 @@ class Translate : public LeafState
 public:
     const char* getName() const override { return "Translate"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
     Translate(StateArgs, Callbacks, PainterVars& vars);
 private:
     void onEnterExt() override;
@@ -154,6 +157,7 @@ public:
     ResizeBrush(StateArgs, Callbacks, PainterVars&);
     const char* getName() const override { return "ResizeBrush"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
 private:
     void onEnterExt() override;
     void onExitExt() override;
@@ -175,9 +179,11 @@ public:
     Paint(StateArgs, Callbacks, PainterVars&, CopyAttachmentToImage&, render::Image&);
     const char* getName() const override { return "Paint"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
 private:
     void onEnterExt() override;
     void onExitExt() override;
+    void addSample(int16_t x, int16_t y);
     glm::vec4 pos{0, 0, 1., 1.};
     float& brushPosX;
     float& brushPosY;
@@ -217,9 +223,12 @@ class Painter final : public BranchState
 public:
     const char* getName() const override { return "Painter"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
     Painter(StateArgs, Callbacks);
     void beginFrame() override;
     void endFrame() override;
+    void saveCheckpoint(event::Checkpoint&) const override;
+    void restoreCheckpoint(event::Checkpoint&) override;
 private:
     enum class Op : Option {initBasic, paint, brushResize, saveAttachmentToPng};
 
@@ -25,15 +25,18 @@ void CreateGraphicsPipeline::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::CommandLine)
     {
         auto ce = toCommandLine(event);
-        auto name = ce->getArg<std::string, 0>();
-        auto pipelineLayout = ce->getArg<std::string, 1>();
-        auto vertshader = ce->getArg<std::string, 2>();
-        auto fragshader = ce->getArg<std::string, 3>();
-        auto renderpass = ce->getArg<std::string, 4>();
-        vk::Rect2D area{
-            {ce->getArg<int, 5>(), ce->getArg<int, 6>()},
-            {ce->getArg<uint32_t, 7>(), ce->getArg<uint32_t, 8>()}};
-        auto is3d = ce->getArg<bool, 9>();
+        std::string name, pipelineLayout, vertshader, fragshader, renderpass;
+        int x, y;
+        uint32_t width, height;
+        bool is3d;
+        auto parsed = ce->parse(0, name, pipelineLayout, vertshader, fragshader, renderpass, x, y, width, height, is3d);
+        if (!parsed)
+        {
+            std::cout << "Could not create the pipeline: " << parsed << '\n';
+            event->setHandled();
+            return;
+        }
+        vk::Rect2D area{{x, y}, {width, height}};
         auto cmd = pool.request(reportCallback(), name, pipelineLayout, vertshader, fragshader, renderpass, area, is3d);
         pushCmd(std::move(cmd));
         popSelf();
@@ -57,13 +60,10 @@ void CreatePipelineLayout::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::CommandLine)
     {
         auto ce = toCommandLine(event);
-        auto ss = ce->getStream();
-        std::string name;
-        std::string layout;
+        auto name = ce->getFirstWord();
         std::vector<std::string> layouts;
-        ss >> name;
-        while (ss >> layout)
-            layouts.push_back(layout);
+        for (size_t i = 1; i < ce->getWordCount(); i++) 
+            layouts.emplace_back(ce->getWord(i));
         auto cmd = pool.request(reportCallback(), name, layouts);
         pushCmd(std::move(cmd));
         popSelf();
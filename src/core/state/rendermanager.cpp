@@ -73,12 +73,11 @@ void RecordRenderCommand::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::CommandLine)
     {
         auto ce = toCommandLine(event);       
-        auto ss = ce->getStream();
-        int cmdBufferId;
+        int cmdBufferId{0};
         uint32_t holder;
         std::vector<uint32_t> renderLayerIds;
-        ss >> cmdBufferId;
-        while (ss >> holder)
+        ce->get(0, cmdBufferId);
+        for (size_t i = 1; i < ce->getWordCount() && ce->get(i, holder); i++) 
             renderLayerIds.push_back(holder);
         auto cmd = pool.request(reportCallback(), cmdBufferId, renderLayerIds);
         pushCmd(std::move(cmd));
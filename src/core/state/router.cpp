@@ -0,0 +1,83 @@
+#include "router.hpp"
+#include "state.hpp"
+
+namespace sword
+{
+
+namespace state
+{
+
+using event::Route;
+
+static constexpr event::WindowEventType windowTypes[] = {
+    event::WindowEventType::Keypress, event::WindowEventType::Keyrelease,
+    event::WindowEventType::MousePress, event::WindowEventType::MouseRelease,
+    event::WindowEventType::Motion, event::WindowEventType::EnterWindow,
+    event::WindowEventType::LeaveWindow};
+
+// a state routed to the same slot more than once is still offered each event once
+void Router::add(size_t slot, State* state, uint8_t detail)
+{
+    auto& entries = table[slot];
+    auto first = entries.end();
+    while (first != entries.begin() && (first - 1)->state == state)
+        first--;
+    for (auto it = first; it != entries.end(); it++)
+        if (it->detail == Route::any || it->detail == detail)
+            return;
+    if (detail == Route::any)
+        entries.erase(first, entries.end());
+    entries.push_back({state, detail});
+}
+
+void Router::rebuild(const StateStack& stack)
+{
+    for (auto& entries : table)
+        entries.clear();
+    for (auto state : stack)
+    {
+        for (const auto& route : state->getRoutes())
+        {
+            if (route.category != event::Category::Window)
+                add(slot(route.category, Route::any), state, Route::any);
+            else if (route.type != Route::any)
+                add(slot(route.category, route.type), state, route.detail);
+            else
+                for (auto type : windowTypes)
+                    add(slot(route.category, static_cast<uint8_t>(type)), state, route.detail);
+        }
+    }
+}
+
+State* Router::route(event::Event& event) const
+{
+    auto category = event.getCategory();
+    uint8_t type = Route::any;
+    uint8_t detail = Route::any;
+    if (category == event::Category::Window)
+    {
+        auto windowType = static_cast<event::Window&>(event).getType();
+        type = static_cast<uint8_t>(windowType);
+        switch (windowType)
+        {
+            case event::WindowEventType::Keypress: case event::WindowEventType::Keyrelease:
+                detail = static_cast<uint8_t>(static_cast<event::Keyboard&>(event).getKey()); break;
+            case event::WindowEventType::MousePress: case event::WindowEventType::MouseRelease:
+                detail = static_cast<uint8_t>(static_cast<event::MouseButton&>(event).getMouseButton()); break;
+            default: break;
+        }
+    }
+    for (const auto& entry : table[slot(category, type)])
+    {
+        if (entry.detail != Route::any && entry.detail != detail)
+            continue;
+        entry.state->handleEvent(&event);
+        if (event.isHandled())
+            return entry.state;
+    }
+    return nullptr;
+}
+
+}; // namespace state
+
+}; // namespace sword
@@ -0,0 +1,44 @@
+#ifndef STATE_ROUTER_HPP
+#define STATE_ROUTER_HPP
+
+//imp: state/router.cpp
+
+#include "statetypes.hpp"
+#include <event/event.hpp>
+#include <array>
+#include <vector>
+
+namespace sword
+{
+
+namespace state
+{
+
+// which states each kind of event goes to, top of the stack first. built from
+// the states' getRoutes whenever the stack changes, so an event only visits
+// the states that asked for it however deep the stack gets
+class Router
+{
+public:
+    void rebuild(const StateStack&);
+    // offers the event to its states until one handles it. returns that state, or null
+    State* route(event::Event&) const;
+private:
+    struct Entry
+    {
+        State* state;
+        uint8_t detail; //event::Route::any or the key or button asked for
+    };
+    static constexpr size_t typeCount = 16; //window event types are all below this
+    static constexpr size_t categoryCount = 8;
+    static size_t slot(event::Category category, uint8_t type) { return static_cast<size_t>(category) * typeCount + (type & (typeCount - 1)); }
+    void add(size_t slot, State* state, uint8_t detail);
+
+    std::array<std::vector<Entry>, categoryCount * typeCount> table;
+};
+
+}; // namespace state
+
+}; // namespace sword
+
+#endif /* end of include guard: STATE_ROUTER_HPP */
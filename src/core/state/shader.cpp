@@ -1,6 +1,9 @@
 #include <state/shader.hpp>
+#include <command/includegraph.hpp>
+#include <algorithm>
 #include <filesystem>
 #include <sstream>
+#include <unordered_map>
 #include <util/file.hpp>
 #include <util/debug.hpp>
 
@@ -53,7 +56,7 @@ CompileShader::CompileShader(StateArgs sa, Callbacks cb) :
 void CompileShader::onEnterExt()
 {
     setVocab(getPaths(SHADER_SRC, true));
-    std::cout << "Enter a shader path and name." << '\n';
+    std::cout << "Enter a shader path and name, or a directory." << '\n';
 }
 
 void CompileShader::handleEvent(event::Event* event)
@@ -63,6 +66,14 @@ void CompileShader::handleEvent(event::Event* event)
         auto ce = toCommandLine(event);       
         auto path = ce->getArg<std::string, 0>();
         auto name = ce->getArg<std::string, 1>();
+        auto dir = std::filesystem::path(SHADER_SRC) / path;
+        if (!path.empty() && std::filesystem::is_directory(dir))
+        {
+            compileDirectory(dir);
+            event->setHandled();
+            popSelf();
+            return;
+        }
         if (name.empty())
         {
             std::cout << "Must specify a shader name." << '\n';
@@ -77,6 +88,42 @@ void CompileShader::handleEvent(event::Event* event)
     }
 }
 
+// every shader under dir, each named after its file. a name two files of the
+// same kind would share is replaced by each one's path under dir, so neither
+// overwrites the other. the commands never share a name, so the graph runs
+// them side by side
+void CompileShader::compileDirectory(const std::filesystem::path& dir)
+{
+    namespace fs = std::filesystem;
+    const fs::path src{SHADER_SRC};
+    std::vector<fs::path> files;
+    std::error_code ec;
+    fs::recursive_directory_iterator it{dir, fs::directory_options::skip_permission_denied, ec};
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) 
+    {
+        auto ext = it->path().extension();
+        if ((ext == ".frag" || ext == ".vert") && it->is_regular_file(ec))
+            files.push_back(it->path());
+    }
+    if (ec)
+        std::cerr << "CompileShader::compileDirectory: stopped reading " << dir << ": " << ec.message() << '\n';
+    std::sort(files.begin(), files.end());
+    std::unordered_map<std::string, size_t> uses; //by file name, which is stem and kind
+    for (const auto& file : files) 
+        uses[file.filename().string()]++;
+    for (const auto& file : files) 
+    {
+        auto name = file.stem().string();
+        if (uses[file.filename().string()] > 1)
+        {
+            name = file.lexically_relative(dir).replace_extension().generic_string();
+            std::cerr << "CompileShader::compileDirectory: more than one " << file.filename() << " under " << dir << ", naming this one " << name << '\n';
+        }
+        pushCmd(pool.request(reportCallback(), file.lexically_relative(src).string(), name));
+    }
+    std::cout << "Compiling " << files.size() << " shaders in " << dir << '\n';
+}
+
 WatchFile::WatchFile(StateArgs sa, Callbacks cb) :
     LeafState{sa, cb}, pool{sa.cp.watchFile}
 {}
@@ -119,11 +166,9 @@ void LoadFragShaders::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::CommandLine)
     {
         auto cmdevent = static_cast<event::CommandLine*>(event);
-        auto stream = cmdevent->getStream();
-        std::string reciever;
-        while (stream >> reciever)
+        for (size_t i = 0; i < cmdevent->getWordCount(); i++) 
         {
-            auto spv = toSpv(reciever);
+            auto spv = toSpv(std::string(cmdevent->getWord(i)));
             auto cmd = lfPool.request(reportCallback(), spv);
             pushCmd(std::move(cmd));
         }
@@ -149,11 +194,9 @@ void LoadVertShaders::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::CommandLine)
     {
         auto cmdevent = static_cast<event::CommandLine*>(event);
-        auto stream = cmdevent->getStream();
-        std::string reciever;
-        while (stream >> reciever)
+        for (size_t i = 0; i < cmdevent->getWordCount(); i++) 
         {
-            auto spv = toSpv(reciever);
+            auto spv = toSpv(std::string(cmdevent->getWord(i)));
             auto cmd = lvPool.request(reportCallback(), spv);
             pushCmd(std::move(cmd));
         }
@@ -183,16 +226,29 @@ void SetSpec::handleEvent(event::Event* event)
 {
     if (event->getCategory() == event::Category::CommandLine)
     {
-        auto stream = toCommandLine(event)->getStream();
-        int first; int second; char type_char; std::string name;
+        auto ce = toCommandLine(event);
+        int first; int second; char type_char;
         ShaderType type;
-        stream >> first >> second >> type_char;
+        auto parsed = ce->parse(0, first, second, type_char);
+        if (!parsed)
+        {
+            std::cout << "Could not set the spec constants: " << parsed << '\n';
+            event->setHandled();
+            return;
+        }
+        if (type_char != 'f' && type_char != 'v')
+        {
+            std::cout << "Could not set the spec constants: bad word 2, expected 'f' or 'v'" << '\n';
+            event->setHandled();
+            return;
+        }
         if (type_char == 'f')
             type = ShaderType::frag;
         else if (type_char == 'v')
             type = ShaderType::vert;
-        while (stream >> name)
+        for (size_t i = 3; i < ce->getWordCount(); i++) 
         {
+            std::string name{ce->getWord(i)};
             auto report = findReport<ShaderReport>(name, reports);
             if (this->type == shader::SpecType::floating)
             {
@@ -245,6 +301,11 @@ ShaderManager::ShaderManager(StateArgs sa, Callbacks cb, ReportCallbackFn<Shader
     activate(opcast(Op::watchFile));
 }
 
+event::Routes ShaderManager::getRoutes() const
+{
+    return {event::Category::CommandLine, event::Category::File};
+}
+
 void ShaderManager::handleEvent(event::Event* event)
 {
     if (event->getCategory() == event::Category::CommandLine)
@@ -266,23 +327,24 @@ void ShaderManager::handleEvent(event::Event* event)
     if (event->getCategory() == event::Category::File)
     {
         //this algorithm ONLY works for fragment shaders currently... it should be fixed
+        //a changed include recompiles every source that pulls it in, side by side
         auto fe = static_cast<event::File*>(event);
-        auto path = fe->getPath();
+        auto path = command::IncludeGraph::normal(fe->getPath());
+        auto sources = command::includeGraph().dependents(path);
+        sources.push_back(path);
         for (const auto& report : shaderReports) 
         {
-            std::invoke(*report);
-            if (report->getSourcePath() == path)
-            {
-                auto rep = report.get();
-                auto cmd = csPool.request(
-                        OwningReportCallbackFn([this](Report* r) {
-                            auto rep = static_cast<ShaderReport*>(r);
-                            std::invoke(srCallback, rep);
-                            }),
-                        path, rep->getObjectName(), rep);
-                pushCmd(std::move(cmd));
-                break;
-            }
+            auto source = command::IncludeGraph::normal(std::string(report->getSourcePath()));
+            if (std::find(sources.begin(), sources.end(), source) == sources.end())
+                continue;
+            auto rep = report.get();
+            auto cmd = csPool.request(
+                    OwningReportCallbackFn([this](Report* r) {
+                        auto rep = static_cast<ShaderReport*>(r);
+                        std::invoke(srCallback, rep);
+                        }),
+                    source, rep->getObjectName(), rep);
+            pushCmd(std::move(cmd));
         }
         event->setHandled();
     }
@@ -87,7 +87,8 @@ public:
     CompileShader(StateArgs, Callbacks);
 private:
     void onEnterExt() override;
-    CommandPool<command::CompileShader>& pool;
+    void compileDirectory(const std::filesystem::path&);
+    CompileShaderPool& pool;
 };
 
 class WatchFile : public LeafState
@@ -106,6 +107,7 @@ class ShaderManager final : public BranchState
 public:
     const char* getName() const override { return "shader_manager"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
     ShaderManager(StateArgs, Callbacks, ReportCallbackFn<ShaderReport>);
 private:
     enum class Op : Option {watchFile, compileShader, printShader, loadFrag, loadVert, setSpecInt, setSpecFloat, printReports};
@@ -125,7 +127,7 @@ private:
 
     ShaderReports shaderReports;
 
-    CommandPool<command::CompileShader>& csPool;
+    CompileShaderPool& csPool;
 };
 
 }; // namespace state
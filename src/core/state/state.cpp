@@ -8,7 +8,7 @@ namespace state
 
 void State::pushCmd(command::Vessel cmd)
 {
-    cmdStack.push(std::move(cmd));
+    command::push(cmdStack, std::move(cmd));
 }
 
 void State::onEnter()
@@ -47,7 +47,7 @@ void State::setVocab(std::vector<std::string> strings)
 void State::updateVocab()
 {
     auto cmd = uvPool.request();
-    cmdStack.push(std::move(cmd));
+    command::push(cmdStack, std::move(cmd));
 }
 
 void State::printVocab()
@@ -76,7 +76,7 @@ void LeafState::onExitImp()
 
 void LeafState::pushCmd(command::Vessel cmd)
 {
-    cmdStack.push(std::move(cmd));
+    command::push(cmdStack, std::move(cmd));
 }
 
 void BranchState::pushState(State* state)
@@ -87,8 +87,7 @@ void BranchState::pushState(State* state)
 Optional BranchState::extractCommand(event::Event* event)
 {
     auto cmdevent = static_cast<event::CommandLine*>(event);
-    std::string input = cmdevent->getFirstWord();
-    return options.findOption(input, topMask); //TODO give this a bitmask parameter to filter the options by
+    return options.findOption(cmdevent->getWord(0), topMask); //TODO give this a bitmask parameter to filter the options by
 }
 //
 //void BranchState::setActiveVocab()
@@ -11,6 +11,7 @@
 #include <command/vocab.hpp>
 #include "option.hpp"
 #include "vocab.hpp"
+#include <util/framepacer.hpp>
 
 #define STATE_BASE(name) \
     void handleEvent(Event* event) override;\
@@ -22,6 +23,7 @@ namespace sword
 {
 
 namespace render{ class Context;}
+namespace event{ struct Checkpoint;}
     
 namespace state
 {
@@ -83,6 +85,7 @@ struct StateArgs
     CommandPools& cp;
     Register& rg;
     render::Context& ct;
+    util::FramePacer& fp;
 };
 
 struct Callbacks
@@ -108,7 +111,7 @@ public:
         return map.getKeys();
     }
 
-    std::optional<Option> findOption(const std::string& s, OptionMask mask) const
+    std::optional<Option> findOption(std::string_view s, OptionMask mask) const
     {
         return map.findValue(s, mask);
     }
@@ -122,16 +125,27 @@ public:
     virtual void handleEvent(event::Event* event) = 0;
     virtual const char* getName() const = 0;
     virtual StateType getType() const = 0;
+    // the events this state is offered, see state/router.hpp. command line
+    // input unless a state says otherwise
+    virtual event::Routes getRoutes() const { return {event::Category::CommandLine}; }
     virtual void beginFrame() {}
     virtual void endFrame() {}
+    // states that keep variables the event stream alone can't rebuild put
+    // them in checkpoints here, and take them back in the same order
+    virtual void saveCheckpoint(event::Checkpoint&) const {}
+    virtual void restoreCheckpoint(event::Checkpoint&) {}
     virtual ~State() = default;
     void onEnter();
     void onExit();
     std::vector<std::string> getVocab();
+    // whether a state asked for a redraw on this thread since the last call. the
+    // application clears it before handing a state an event and reads it after,
+    // so the redraw is put down to that event and not to a command running beside it
+    static bool takeRedrawRequest() { bool asked = redrawAsked; redrawAsked = false; return asked; }
 //    virtual std::vector<const Report*> getReports() const {return {};};
 protected:
-    State(command::Queue& cs) : cmdStack{cs} {}
-    State(command::Queue& cs, ExitCallbackFn callback) : cmdStack{cs}, onExitCallback{callback} {}
+    State(command::Queue& cs, util::FramePacer& fp) : cmdStack{cs}, framePacer{fp} {}
+    State(command::Queue& cs, util::FramePacer& fp, ExitCallbackFn callback) : cmdStack{cs}, framePacer{fp}, onExitCallback{callback} {}
     void setVocab(std::vector<std::string> strings);
     void clearVocab() { vocab.clear(); }
     void addToVocab(std::string word) { vocab.push_back(word); }
@@ -139,12 +153,16 @@ protected:
     void printVocab();
     void pushCmd(command::Vessel);
     void setVocabMask(OptionMask* mask) { vocab.setMaskPtr(mask); }
+    void requestRedraw() { framePacer.requestRedraw(); redrawAsked = true; } //call when something that gets drawn has changed
+    float sessionTime() const { return std::chrono::duration<float>(framePacer.clock()).count(); } //seconds. use this for anything animated, replays depend on it
 private:
+    inline static thread_local bool redrawAsked{false};
     command::Pool<command::UpdateVocab, 3> uvPool;
     command::Pool<command::PopVocab, 3> pvPool;
     command::Pool<command::AddVocab, 3> avPool;
     Vocab vocab;
     command::Queue& cmdStack;
+    util::FramePacer& framePacer;
     ExitCallbackFn onExitCallback{nullptr};
     virtual void onEnterImp();
     virtual void onExitImp();
@@ -161,7 +179,7 @@ public:
     const OwningReportCallbackFn reportCallback() const { return reportCallbackFn; }
 protected:
     LeafState(StateArgs sa, Callbacks cb) :
-        State{sa.cs, cb.ex}, cmdStack{sa.cs}, editStack{sa.es}, reportCallbackFn{cb.rp} {}
+        State{sa.cs, sa.fp, cb.ex}, cmdStack{sa.cs}, editStack{sa.es}, reportCallbackFn{cb.rp} {}
     void popSelf() { editStack.popState(); }
     void pushCmd(command::Vessel ptr);
 
@@ -194,6 +212,7 @@ class BriefState : public LeafState
 public:
     StateType getType() const override { return StateType::brief; }
     void handleEvent(event::Event*) override final {}; //no events for this guy
+    event::Routes getRoutes() const override final { return {}; }
 protected:
     BriefState(StateArgs sa, Callbacks cb) :
         LeafState{sa, cb} 
@@ -236,7 +255,7 @@ public:
 protected:
     using Element = std::pair<std::string, Option>;
     BranchState(StateArgs sa, Callbacks cb, std::initializer_list<Element> ops) :
-        State{sa.cs, cb.ex}, editStack{sa.es}, options{ops}
+        State{sa.cs, sa.fp, cb.ex}, editStack{sa.es}, options{ops}
     {
         setVocab(options.getStrings());
         setVocabMask(&topMask); 
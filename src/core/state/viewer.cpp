@@ -62,7 +62,7 @@ static float distance(float x1, float y1, float x2, float y2)
 static int findVertInRange(float x, float y)
 {
     size_t count = sizeof(vertices) / sizeof(vertices[0]);
-    SWD_DEBUG_MSG("count " << count);
+    SWD_TRACE_MSG("count " << count);
     for (int i = 0; i < count; i++) 
     {
         auto pos = vertices[i].pos;
@@ -80,6 +80,12 @@ static float normalize(int16_t x)
 
 static bool moverActive = false;
 
+event::Routes Viewer::getRoutes() const
+{
+    return {event::Category::CommandLine, {event::WindowEventType::MousePress, event::symbol::MouseButton::Left}, 
+        {event::WindowEventType::MouseRelease, event::symbol::MouseButton::Left}, event::WindowEventType::Motion};
+}
+
 void Viewer::handleEvent(event::Event* event)
 {
     if (event->getCategory() == event::Category::CommandLine)
@@ -134,6 +140,7 @@ void Viewer::handleEvent(event::Event* event)
             float diffY = normalize(we->getY()) - initY;
             vertices[curVert].pos.x = initVertX + diffX;
             vertices[curVert].pos.y = initVertY + diffY;
+            requestRedraw();
             return;
         }
     }
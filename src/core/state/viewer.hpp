@@ -24,6 +24,7 @@ class Viewer final : public BranchState
 public:
     const char* getName() const override { return "Viewer"; }
     void handleEvent(event::Event*) override;
+    event::Routes getRoutes() const override;
     virtual ~Viewer() = default;
     Viewer(StateArgs, Callbacks);
     void endFrame() override;
@@ -3,6 +3,8 @@
 
 #include "option.hpp"
 #include <iostream>
+#include <string>
+#include <vector>
 
 namespace sword
 {
@@ -13,10 +15,14 @@ namespace state
 class Vocab
 {
 public:
-    void clear() { words.clear(); }
-    void push_back(std::string word) { words.push_back(word); }
-    void set( std::vector<std::string> strings) { words = strings; }
+    void clear() { words.clear(); version++; }
+    void push_back(std::string word) { words.push_back(word); version++; }
+    void set( std::vector<std::string> strings) { words = strings; version++; }
     void setMaskPtr( OptionMask* ptr ) { mask = ptr; }
+    // for the completion index, which follows the words by version and the mask bit by bit
+    const std::vector<std::string>& getAllWords() const { return words; }
+    const OptionMask* getMask() const { return mask; }
+    uint64_t getVersion() const { return version; }
     std::vector<std::string> getWords() const 
     {
         if (mask)
@@ -47,6 +53,7 @@ public:
 private:
     OptionMask* mask{nullptr};
     std::vector<std::string> words;
+    uint64_t version{0}; //bumped whenever words changes
 };
 
 }; // namespace state
@@ -23,7 +23,10 @@ public:
 //        instream >> input;
 //        return findOption(input);
 //    }
-    std::optional<T> findValue(const S& s) const 
+    // K is anything S compares equal with, so a string_view finds a string key
+    // without making one
+    template <typename K>
+    std::optional<T> findValue(const K& s) const 
     {
         for (const auto& item : options) 
             if (item.first == s)
@@ -31,8 +34,8 @@ public:
         return {};
     }
 
-    template <size_t N>
-    std::optional<T> findValue(const S& s, std::bitset<N> mask) const 
+    template <typename K, size_t N>
+    std::optional<T> findValue(const K& s, std::bitset<N> mask) const 
     {
         for (int i = 0; i < options.size(); i++) 
             if (mask[options[i].second] && options[i].first == s)
@@ -3,9 +3,13 @@
 
 #include <memory>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <vector>
 #include <iostream>
+#include <mutex>
 #include <render/command.hpp>
 #include <util/debug.hpp>
 //#include <concepts>
@@ -30,34 +34,147 @@ namespace container
 // clang still gets this wrong. gcc is fine with it, but im sick of seeing the 
 // error diagnostics
 
+// whatever hands out the slots a vessel points into. lets a vessel give its slot
+// back without knowing the size or element type of the pool it came from
+class SlotOwner
+{
+public:
+    virtual void release(size_t slot) = 0;
+protected:
+    ~SlotOwner() = default;
+};
+
 template<typename T>
 class PoolVessel
 {
 public:
     PoolVessel() = default;
     PoolVessel(T* pT) { handle = pT; }
-    ~PoolVessel() { if (handle) handle->reset(); }
+    PoolVessel(T* pT, SlotOwner* owner, size_t slot) : handle{pT}, owner{owner}, slot{slot} {}
+    ~PoolVessel() { release(); }
     PoolVessel(const PoolVessel&) = delete;
     PoolVessel& operator=(const PoolVessel&) = delete;
     PoolVessel& operator=(PoolVessel&& other) 
     { 
         if (this == &other) return *this;
-        handle = other.handle; other.handle = nullptr; return *this;
+        release();
+        handle = other.handle; owner = other.owner; slot = other.slot;
+        other.handle = nullptr; other.owner = nullptr; 
+        return *this;
+    }
+    PoolVessel(PoolVessel&& other) : handle{other.handle}, owner{other.owner}, slot{other.slot} 
+    {
+        other.handle = nullptr; other.owner = nullptr;
     }
-    PoolVessel(PoolVessel&& other) : handle{other.handle} {other.handle = nullptr;}
     T* operator->() { return handle; }
     T* get() { return handle; }
     operator bool() const { return handle != nullptr; }
 private:
     T* handle = nullptr;
+    SlotOwner* owner = nullptr;
+    size_t slot = 0;
+
+    void release()
+    {
+        if (handle) handle->reset();
+        if (owner) owner->release(slot);
+        handle = nullptr; owner = nullptr;
+    }
+};
+
+// free slots are kept on a lock-free stack of indices, so both request and
+// release are O(1) no matter how big the pool is. requests and releases usually
+// happen on different threads (events are requested on the input threads and
+// released on the main thread, commands are requested on the main thread and
+// released on the worker), hence the atomics. the head carries a tag that is 
+// bumped on every swap so a slot that is popped and pushed back between our
+// load and our compare_exchange can't fool us (ABA).
+template <size_t Size>
+class FreeList
+{
+public:
+    static_assert(Size > 0 && Size < UINT32_MAX);
+    static constexpr uint32_t endOfList = UINT32_MAX;
+
+    FreeList()
+    {
+        for (uint32_t i = 0; i < Size; i++) 
+            next[i].store(i + 1 < Size ? i + 1 : endOfList, std::memory_order_relaxed);
+        head.store(pack(0, 0), std::memory_order_release);
+    }
+
+    // endOfList if there is nothing left
+    uint32_t pop()
+    {
+        uint64_t h = head.load(std::memory_order_acquire);
+        while (indexOf(h) != endOfList)
+        {
+            uint32_t n = next[indexOf(h)].load(std::memory_order_relaxed);
+            if (head.compare_exchange_weak(h, pack(tagOf(h) + 1, n),
+                        std::memory_order_acquire, std::memory_order_acquire))
+                return indexOf(h);
+        }
+        return endOfList;
+    }
+
+    void push(uint32_t slot)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        do 
+        {
+            next[slot].store(indexOf(h), std::memory_order_relaxed);
+        } while (!head.compare_exchange_weak(h, pack(tagOf(h) + 1, slot),
+                    std::memory_order_release, std::memory_order_relaxed));
+    }
+
+private:
+    std::array<std::atomic<uint32_t>, Size> next;
+    std::atomic<uint64_t> head;
+
+    static constexpr uint64_t pack(uint32_t tag, uint32_t index) { return (uint64_t(tag) << 32) | index; }
+    static constexpr uint32_t indexOf(uint64_t h) { return static_cast<uint32_t>(h); }
+    static constexpr uint32_t tagOf(uint64_t h) { return static_cast<uint32_t>(h >> 32); }
+};
+
+// how many slots are out right now, and the most that have ever been out at once.
+// use the high water mark to size the fixed pools
+class Occupancy
+{
+public:
+    void acquired()
+    {
+        size_t now = current.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t high = peak.load(std::memory_order_relaxed);
+        while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed));
+    }
+    void released() { current.fetch_sub(1, std::memory_order_relaxed); }
+    size_t get() const { return current.load(std::memory_order_relaxed); }
+    size_t highWaterMark() const { return peak.load(std::memory_order_relaxed); }
+private:
+    std::atomic<size_t> current{0};
+    std::atomic<size_t> peak{0};
 };
 
 template <typename T, typename Base, size_t Size>
-class Pool
+class Pool : public SlotOwner
 {
 private:
     std::unique_ptr<render::CommandPool_t<Size>> gpuCommandPool;
     std::array<T, Size> pool;
+    FreeList<Size> freeList;
+    Occupancy occupancy;
+
+    uint32_t acquireSlot()
+    {
+        auto i = freeList.pop();
+        if (i == FreeList<Size>::endOfList)
+        {
+            SWD_DEBUG_MSG("No more room. Size: " << Size);
+            throw std::runtime_error("Ran out of room in pool. ");
+        }
+        occupancy.acquired();
+        return i;
+    }
 
 public:
     //using Pointer = std::unique_ptr<Base, std::function<void(Base*)>>;
@@ -83,37 +200,38 @@ public:
         }
     }
 
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
     template <typename... Args> 
     Vessel request(Args... args)
     {
-        for (int i = 0; i < Size; i++) 
-            if (pool[i].isAvailable())
-            {
-                pool[i].set(args...);
-                pool[i].activate();
-                Vessel vessel{&pool[i]};
-                return vessel; //tentatively may need to be std::move? copy should be ellided tho
-            }    
-        SWD_DEBUG_MSG("No more room. Size: " << Size);
-        throw std::runtime_error("Ran out of room in pool. ");
+        auto i = acquireSlot();
+        pool[i].set(args...);
+        pool[i].activate();
+        return Vessel{&pool[i], this, i};
     }
 
     template <typename... Args> 
     Vessel request(std::function<void(state::Report*)> reportCb, Args... args) //requires IsCommand<T>
     {
-        for (int i = 0; i < Size; i++) 
-            if (pool[i].isAvailable())
-            {
-                pool[i].setSuccessFn(reportCb);
-                pool[i].set(args...);
-                pool[i].activate();
-                Vessel vessel{&pool[i]};
-                return vessel; //tentatively may need to be std::move? copy should be ellided tho
-            }    
-        SWD_DEBUG_MSG("No more room. Size: " << Size);
-        throw std::runtime_error("Ran out of room in pool. ");
+        auto i = acquireSlot();
+        pool[i].setSuccessFn(reportCb);
+        pool[i].set(args...);
+        pool[i].activate();
+        return Vessel{&pool[i], this, i};
+    }
+
+    void release(size_t slot) override
+    {
+        freeList.push(slot);
+        occupancy.released();
     }
 
+    static constexpr size_t capacity() { return Size; }
+    size_t inUse() const { return occupancy.get(); }
+    size_t highWaterMark() const { return occupancy.highWaterMark(); }
+
     static void printAll(Pool* pool) 
     {
         for (auto& i : pool->pool) 
@@ -122,6 +240,195 @@ public:
 
 };
 
+// opt-in alternative to Pool for places where running out of room would be fatal,
+// like the motion events during a fast drag. instead of throwing it adds another
+// chunk of ChunkSize slots. chunks are never moved, so vessels stay valid. the
+// first chunk lives as long as the pool; the rest are handed back by trim once
+// they have sat empty for idlePeriod. trim is for the owner to call now and then,
+// requests and releases never do.
+//
+// a requester reserves a slot in a chunk by decrementing freeCount before popping
+// from its free list, so a chunk whose freeCount is still ChunkSize has nothing out
+// and nobody about to take something out. trim closes such a chunk by swapping its
+// freeCount for a large negative number and unhooks it from the directory. a
+// request or release may still be looking at it, so it is only retired, and
+// deleted by the first trim that sees no request or release in flight.
+// a release stamps emptySince before it hands its slot back, so once freeCount
+// reads ChunkSize the stamp is no older than the last release
+template <typename T, typename Base, size_t ChunkSize, size_t MaxChunks = 64>
+class SlabPool : public SlotOwner
+{
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int64_t closed = INT64_MIN / 2;
+
+    struct Chunk
+    {
+        std::array<T, ChunkSize> items;
+        FreeList<ChunkSize> freeList;
+        std::atomic<int64_t> freeCount{ChunkSize};
+        std::atomic<Clock::rep> emptySince{Clock::now().time_since_epoch().count()};
+    };
+
+    std::array<std::atomic<Chunk*>, MaxChunks> chunks{};
+    std::atomic<size_t> chunkCount{0};
+    std::atomic<size_t> liveChunks{0};
+    std::atomic<size_t> activeRequests{0};
+    std::atomic<size_t> activeReleases{0};
+    std::mutex growLock;
+    std::vector<Chunk*> retired; //unhooked, not yet deleted. under growLock
+    Clock::duration idlePeriod;
+    Occupancy occupancy;
+    std::atomic<size_t> chunkPeak{0};
+
+    std::pair<T*, size_t> acquireSlot()
+    {
+        while (1)
+        {
+            activeRequests.fetch_add(1);
+            size_t count = chunkCount.load();
+            for (size_t c = 0; c < count; c++) 
+            {
+                Chunk* chunk = chunks[c].load();
+                if (!chunk)
+                    continue;
+                if (chunk->freeCount.fetch_sub(1) <= 0)
+                {
+                    chunk->freeCount.fetch_add(1);
+                    continue;
+                }
+                uint32_t i;
+                //the reservation guarantees there is a slot for us
+                while ((i = chunk->freeList.pop()) == FreeList<ChunkSize>::endOfList);
+                activeRequests.fetch_sub(1);
+                occupancy.acquired();
+                return {&chunk->items[i], c * ChunkSize + i};
+            }
+            activeRequests.fetch_sub(1);
+            if (!grow())
+            {
+                SWD_DEBUG_MSG("No more room. Chunks: " << MaxChunks << " ChunkSize: " << ChunkSize);
+                throw std::runtime_error("Ran out of room in slab pool. ");
+            }
+        }
+    }
+
+    bool grow()
+    {
+        std::lock_guard<std::mutex> guard{growLock};
+        size_t count = chunkCount.load();
+        //someone may have grown or released while we waited on the lock
+        for (size_t c = 0; c < count; c++) 
+        {
+            Chunk* chunk = chunks[c].load();
+            if (chunk && chunk->freeCount.load() > 0)
+                return true;
+        }
+        for (size_t c = 0; c < MaxChunks; c++) 
+        {
+            if (chunks[c].load())
+                continue;
+            chunks[c].store(new Chunk);
+            if (c >= count)
+                chunkCount.store(c + 1);
+            size_t live = liveChunks.fetch_add(1) + 1;
+            if (live > chunkPeak.load())
+                chunkPeak.store(live);
+            return true;
+        }
+        return false;
+    }
+
+public:
+    using Vessel = PoolVessel<Base>;
+
+    SlabPool(std::chrono::milliseconds idlePeriod = std::chrono::seconds(5)) :
+        idlePeriod{idlePeriod}
+    {
+        grow();
+    }
+
+    ~SlabPool()
+    {
+        for (auto& chunk : chunks) 
+            delete chunk.load();
+        for (auto chunk : retired) 
+            delete chunk;
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    template <typename... Args> 
+    Vessel request(Args... args)
+    {
+        auto [item, slot] = acquireSlot();
+        item->set(args...);
+        item->activate();
+        return Vessel{item, this, slot};
+    }
+
+    template <typename... Args> 
+    Vessel request(std::function<void(state::Report*)> reportCb, Args... args) //requires IsCommand<T>
+    {
+        auto [item, slot] = acquireSlot();
+        item->setSuccessFn(reportCb);
+        item->set(args...);
+        item->activate();
+        return Vessel{item, this, slot};
+    }
+
+    void release(size_t slot) override
+    {
+        activeReleases.fetch_add(1);
+        Chunk* chunk = chunks[slot / ChunkSize].load();
+        chunk->freeList.push(slot % ChunkSize);
+        occupancy.released();
+        chunk->emptySince.store(Clock::now().time_since_epoch().count());
+        //the chunk may be trimmed from here on, so it is not touched again
+        chunk->freeCount.fetch_add(1);
+        activeReleases.fetch_sub(1);
+    }
+
+    // hands back every chunk but the first that has been empty for at least
+    // idlePeriod. never blocks or waits: if someone else holds the lock, or a
+    // request or release is under way, what is left over goes on the next call
+    void trim()
+    {
+        std::unique_lock<std::mutex> guard{growLock, std::try_to_lock};
+        if (!guard)
+            return;
+        auto now = Clock::now().time_since_epoch().count();
+        size_t count = chunkCount.load();
+        for (size_t c = 1; c < count; c++) 
+        {
+            Chunk* chunk = chunks[c].load();
+            if (!chunk || now - chunk->emptySince.load() < idlePeriod.count())
+                continue;
+            int64_t allFree = ChunkSize;
+            if (!chunk->freeCount.compare_exchange_strong(allFree, closed))
+                continue;
+            chunks[c].store(nullptr);
+            retired.push_back(chunk);
+            liveChunks.fetch_sub(1);
+        }
+        //nothing in flight now means whatever was in flight when these were
+        //unhooked is done, and anything since can't have found them
+        if (!retired.empty() && activeRequests.load() == 0 && activeReleases.load() == 0)
+        {
+            for (auto chunk : retired) 
+                delete chunk;
+            retired.clear();
+        }
+    }
+
+    void setIdlePeriod(std::chrono::milliseconds period) { idlePeriod = period; }
+    size_t capacity() const { return liveChunks.load() * ChunkSize; }
+    size_t inUse() const { return occupancy.get(); }
+    size_t highWaterMark() const { return occupancy.highWaterMark(); }
+    size_t chunkHighWaterMark() const { return chunkPeak.load(); }
+};
+
 
 } // namespace container
 
@@ -1,7 +1,11 @@
 #ifndef TYPES_QUEUE_HPP
 #define TYPES_QUEUE_HPP
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <mutex>
 #include <cassert>
@@ -44,6 +48,207 @@ private:
     std::mutex lock;
 };
 
+// bounded FIFO whose consumer can sleep until something is pushed, rather than
+// polling. push waits for room if the queue is full, so the consumer must never
+// push to its own queue, and neither should anything the consumer waits on.
+// those use pushOrDefer, which parks the item in an unbounded overflow behind
+// the ring instead of waiting. overflowed items are moved into the ring as it
+// drains, and nothing else gets in until they have, so the order is still the
+// push order.
+// a consumer that calls taskDone once it has finished with each item it popped
+// lets other threads wait in waitIdle until everything pushed so far, and
+// anything pushed while handling it, is done.
+template <typename T, size_t N>
+class BlockingQueue
+{
+public:
+    void push(T&& item)
+    {
+        {
+            std::unique_lock<std::mutex> guard{lock};
+            notFull.wait(guard, [this]{ return count < N && overflow.empty(); });
+            items[(first + count) % N] = std::move(item);
+            count++;
+            unfinished++;
+        }
+        notEmpty.notify_one();
+    }
+    // never waits
+    void pushOrDefer(T&& item)
+    {
+        {
+            std::lock_guard<std::mutex> guard{lock};
+            if (count == N || !overflow.empty())
+                overflow.push_back(std::move(item));
+            else
+            {
+                items[(first + count) % N] = std::move(item);
+                count++;
+            }
+            unfinished++;
+        }
+        notEmpty.notify_one();
+    }
+    // sleeps until there is something to hand out
+    T waitPop()
+    {
+        T t;
+        {
+            std::unique_lock<std::mutex> guard{lock};
+            notEmpty.wait(guard, [this]{ return count > 0; });
+            t = std::move(items[first]);
+            first = (first + 1) % N;
+            count--;
+            if (!overflow.empty())
+            {
+                items[(first + count) % N] = std::move(overflow.front());
+                overflow.pop_front();
+                count++;
+            }
+        }
+        notFull.notify_one();
+        return t;
+    }
+    void taskDone()
+    {
+        std::lock_guard<std::mutex> guard{lock};
+        assert(unfinished > 0);
+        if (--unfinished == 0)
+            idle.notify_all();
+    }
+    void waitIdle()
+    {
+        std::unique_lock<std::mutex> guard{lock};
+        idle.wait(guard, [this]{ return unfinished == 0; });
+    }
+    bool isIdle() const { std::lock_guard<std::mutex> guard{lock}; return unfinished == 0; }
+    bool empty() const { std::lock_guard<std::mutex> guard{lock}; return count == 0; }
+    size_t size() const { std::lock_guard<std::mutex> guard{lock}; return count + overflow.size(); }
+private:
+    std::array<T, N> items;
+    size_t first{0};
+    size_t count{0};
+    size_t unfinished{0};
+    std::deque<T> overflow; //only ever non-empty while the ring is full
+    mutable std::mutex lock;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::condition_variable idle;
+};
+
+// bounded ring for many producers and a single consumer. items come out in the
+// order they went in. a push is a handful of atomic increments and never waits on
+// anyone: it reserves room with count, claims a position with tail, writes the
+// slot and then marks it ready. if there is no room the item is left with the 
+// caller and the drop is counted, so the consumer can report it.
+// only the consumer may call pop, popAll and empty.
+template <typename T, size_t N>
+class MpscQueue
+{
+public:
+    bool push(T&& item)
+    {
+        size_t depth = count.fetch_add(1, std::memory_order_acq_rel) + 1;
+        if (depth > N)
+        {
+            count.fetch_sub(1, std::memory_order_relaxed);
+            drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        size_t high = peak.load(std::memory_order_relaxed);
+        while (depth > high && !peak.compare_exchange_weak(high, depth, std::memory_order_relaxed));
+        size_t pos = tail.fetch_add(1, std::memory_order_relaxed);
+        auto& slot = slots[pos % N];
+        slot.item = std::move(item);
+        slot.ready.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // pushes items[0, n) with one reservation, so a producer holding a burst
+    // touches count and tail once instead of once per item. if only some of
+    // them fit, the first ones go in and the rest are left with the caller
+    // and counted as drops. returns how many went in
+    size_t pushBatch(T* items, size_t n)
+    {
+        if (n == 0)
+            return 0;
+        size_t depth = count.load(std::memory_order_relaxed);
+        size_t k;
+        do
+        {
+            k = depth < N ? std::min(n, N - depth) : 0;
+            if (k == 0)
+                break;
+        } while (!count.compare_exchange_weak(depth, depth + k, std::memory_order_acq_rel));
+        if (k < n)
+            drops.fetch_add(n - k, std::memory_order_relaxed);
+        if (k == 0)
+            return 0;
+        size_t high = peak.load(std::memory_order_relaxed);
+        while (depth + k > high && !peak.compare_exchange_weak(high, depth + k, std::memory_order_relaxed));
+        size_t pos = tail.fetch_add(k, std::memory_order_relaxed);
+        for (size_t i = 0; i < k; i++)
+        {
+            auto& slot = slots[(pos + i) % N];
+            slot.item = std::move(items[i]);
+            slot.ready.store(pos + i + 1, std::memory_order_release);
+        }
+        return k;
+    }
+
+    // an empty T if nothing is ready
+    T pop()
+    {
+        auto& slot = slots[head % N];
+        if (slot.ready.load(std::memory_order_acquire) != head + 1)
+            return T{};
+        T t = std::move(slot.item);
+        head++;
+        count.fetch_sub(1, std::memory_order_release);
+        return t;
+    }
+
+    // hands everything that was ready when we started to fn, oldest first. items
+    // pushed while we are draining wait for the next call. returns how many were handed out
+    template <typename F>
+    size_t popAll(F&& fn)
+    {
+        size_t end = tail.load(std::memory_order_acquire);
+        size_t n = 0;
+        while (head != end)
+        {
+            auto& slot = slots[head % N];
+            if (slot.ready.load(std::memory_order_acquire) != head + 1)
+                break; //claimed but not written yet, pick it up next time
+            T t = std::move(slot.item);
+            head++;
+            count.fetch_sub(1, std::memory_order_release);
+            fn(std::move(t));
+            n++;
+        }
+        return n;
+    }
+
+    bool empty() const { return slots[head % N].ready.load(std::memory_order_acquire) != head + 1; }
+    size_t size() const { return std::min(count.load(std::memory_order_relaxed), N); }
+    bool isFull() const { return size() == N; }
+    static constexpr size_t capacity() { return N; }
+    size_t dropped() const { return drops.load(std::memory_order_relaxed); }
+    size_t highWaterMark() const { return peak.load(std::memory_order_relaxed); }
+private:
+    struct Slot
+    {
+        T item;
+        std::atomic<size_t> ready{0}; //position + 1 once the item is written
+    };
+    std::array<Slot, N> slots;
+    alignas(64) std::atomic<size_t> count{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t head{0};
+    std::atomic<size_t> drops{0};
+    std::atomic<size_t> peak{0};
+};
+
 } // namespace sword
 
 
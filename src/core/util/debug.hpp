@@ -2,7 +2,10 @@
 #define UTIL_DEBUG_HPP
 
 #include <iostream>
+#include <util/log.hpp>
 
-#define SWD_DEBUG_MSG(msg) std::cerr << __FILE__ << ": " << __PRETTY_FUNCTION__ << ": " << msg << '\n';
+#define SWD_DEBUG_MSG(msg) SWD_LOG(debug, __FILE__ << ": " << __PRETTY_FUNCTION__ << ": " << msg)
+//for things that happen every event or every command
+#define SWD_TRACE_MSG(msg) SWD_LOG(trace, __FILE__ << ": " << __PRETTY_FUNCTION__ << ": " << msg)
 
 #endif /* end of include guard: UTIL_DEBUG_HPP */
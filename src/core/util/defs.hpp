@@ -4,6 +4,8 @@
 #define SWORD "/home/michaelb/dev/sword"
 #define SHADER_DIR SWORD"/build/shaders"
 #define SHADER_SRC SWORD"/src/shaders"
+#define SPIRV_CACHE SWORD"/build/spvcache"
+#define SHADER_BUNDLE SWORD"/build/shaders.bundle"
 #define GLSLC "/home/michaelb/dev/Vulkan/1.1.126.0/x86_64/bin/glslc"
 
 #endif /* end of include guard: UTIL_DEFS_HPP */
@@ -0,0 +1,125 @@
+#ifndef UTIL_FRAMEPACER_HPP
+#define UTIL_FRAMEPACER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace sword
+{
+
+namespace util
+{
+
+// decides when the frame loop should draw and how long it should sleep.
+// anything that changes what ends up on screen calls requestRedraw. frames
+// without a redraw request skip submit and present, and once nothing is 
+// happening the loop sleeps until wake is called (new input, a command
+// finishing) instead of spinning at the frame rate.
+// requestRedraw and wake may be called from any thread.
+class FramePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FramePacer(int targetFps = 60) { setTargetFps(targetFps); }
+
+    void setTargetFps(int fps) 
+    { 
+        framePeriod = fps > 0 ? Clock::duration(std::chrono::seconds(1)) / fps : Clock::duration::zero(); 
+    }
+
+    // zero never sleeps between frames
+    void setTargetFramePeriod(Clock::duration period) { framePeriod = period; }
+
+    void requestRedraw() 
+    { 
+        dirty.store(true); 
+        wake(); 
+    }
+
+    // true if a redraw was requested since the last call
+    bool takeRedraw() { return dirty.exchange(false); }
+
+    // sleeping, woken and the lock form the usual handshake: the sleeper sets
+    // sleeping before it checks woken, the waker sets woken before it checks
+    // sleeping, so at least one of them sees the other. wakers only touch the
+    // lock when someone is actually asleep
+    void wake()
+    {
+        woken.store(true);
+        if (sleeping.load())
+        {
+            std::lock_guard<std::mutex> guard{lock};
+            cv.notify_one();
+        }
+    }
+
+    void beginFrame() { frameStart = Clock::now(); }
+
+    // call once the frame's work is done. sleeps off whatever is left of the frame
+    // period. if the frame was idle it keeps sleeping until woken, or until
+    // idleTimeout so per frame hooks still get a chance to run
+    void endFrame(bool idle)
+    {
+        auto now = Clock::now();
+        frameTime = now - frameStart;
+        if (idle)
+            sleepUntil(now + idleTimeout, true);
+        else
+            sleepUntil(frameStart + framePeriod, false);
+    }
+
+    Clock::duration lastFrameTime() const { return frameTime; }
+    Clock::duration targetFramePeriod() const { return framePeriod; }
+
+    // session time for anything that animates. it follows the wall clock until
+    // a replay takes it over with setClock, so replayed frames see the same
+    // times on every run. resumeClock hands it back to the wall clock, carrying
+    // on from wherever the replay left it. frame loop thread only
+    Clock::duration clock() const { return live ? clockBase + (Clock::now() - liveSince) : clockBase; }
+    void setClock(Clock::duration t) { live = false; clockBase = t; }
+    void resumeClock() 
+    { 
+        clockBase = clock(); 
+        liveSince = Clock::now(); 
+        live = true; 
+    }
+
+private:
+    static constexpr auto idleTimeout = std::chrono::milliseconds(250);
+
+    Clock::duration framePeriod;
+    Clock::duration frameTime{0};
+    Clock::time_point frameStart{Clock::now()};
+    Clock::time_point liveSince{Clock::now()};
+    Clock::duration clockBase{0};
+    bool live{true};
+    std::atomic<bool> dirty{true};
+    std::atomic<bool> woken{false};
+    std::atomic<bool> sleeping{false};
+    std::mutex lock;
+    std::condition_variable cv;
+
+    void sleepUntil(Clock::time_point deadline, bool interruptible)
+    {
+        if (!interruptible)
+        {
+            std::this_thread::sleep_until(deadline);
+            return;
+        }
+        std::unique_lock<std::mutex> guard{lock};
+        sleeping.store(true);
+        cv.wait_until(guard, deadline, [this]{ return woken.load(); });
+        sleeping.store(false);
+        woken.store(false);
+    }
+};
+
+}; // namespace util
+
+}; // namespace sword
+
+#endif /* end of include guard: UTIL_FRAMEPACER_HPP */
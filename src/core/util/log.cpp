@@ -0,0 +1,160 @@
+#include "log.hpp"
+#include <types/queue.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+
+namespace sword
+{
+
+namespace util
+{
+
+namespace log
+{
+
+namespace
+{
+    constexpr size_t RecordSize = 256;
+    constexpr size_t RingSize = 4096;
+
+    struct Record
+    {
+        Level level{Level::off};
+        uint16_t length{0};
+        char text[RecordSize];
+    };
+
+    // writes into a fixed buffer and quietly stops at the end of it
+    class RecordBuf : public std::streambuf
+    {
+    public:
+        RecordBuf() { rewind(); }
+        void rewind() { setp(buffer, buffer + RecordSize); }
+        const char* data() const { return pbase(); }
+        size_t size() const { return pptr() - pbase(); }
+    protected:
+        int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    private:
+        char buffer[RecordSize];
+    };
+
+    struct ThreadRecord
+    {
+        RecordBuf buf;
+        std::ostream stream{&buf};
+    };
+
+    ThreadRecord& threadRecord()
+    {
+        thread_local ThreadRecord record;
+        return record;
+    }
+
+    // never destroyed: detached threads may still log on the way out. whatever
+    // is left in the ring gets written by the atexit flush instead
+    class Writer
+    {
+    public:
+        Writer()
+        {
+            std::thread(&Writer::run, this).detach();
+            std::atexit([]() { flush(); });
+        }
+
+        void push(Record&& record)
+        {
+            bool urgent = record.level >= Level::warn;
+            if (ring.push(std::move(record)) && urgent)
+                wake.notify_one();
+        }
+
+        // drains the ring. only one thread can be the consumer at a time
+        void drain()
+        {
+            std::lock_guard<std::mutex> guard(consumerLock);
+            ring.popAll([](Record&& r)
+            {
+                auto& os = r.level == Level::info ? std::cout : std::cerr;
+                os.write(r.text, r.length);
+                os.put('\n');
+            });
+            auto dropped = ring.dropped();
+            if (dropped != reportedDrops)
+            {
+                std::cerr << "log: " << dropped - reportedDrops << " records dropped, ring was full" << '\n';
+                reportedDrops = dropped;
+            }
+            std::cout.flush();
+        }
+
+        std::atomic<Level> level{compiledLevel};
+
+    private:
+        container::MpscQueue<Record, RingSize> ring;
+        std::mutex consumerLock;
+        std::mutex sleepLock;
+        std::condition_variable wake;
+        size_t reportedDrops{0};
+
+        void run()
+        {
+            while (1)
+            {
+                drain();
+                std::unique_lock<std::mutex> guard(sleepLock);
+                wake.wait_for(guard, std::chrono::milliseconds(10));
+            }
+        }
+    };
+
+    Writer& writer()
+    {
+        static Writer* instance = new Writer();
+        return *instance;
+    }
+};
+
+bool enabled(Level l)
+{
+    return l >= writer().level.load(std::memory_order_relaxed);
+}
+
+void setLevel(Level l)
+{
+    writer().level.store(l < compiledLevel ? compiledLevel : l, std::memory_order_relaxed);
+}
+
+std::ostream& beginRecord()
+{
+    auto& record = threadRecord();
+    record.buf.rewind();
+    record.stream.clear();
+    return record.stream;
+}
+
+void endRecord(Level l)
+{
+    auto& buf = threadRecord().buf;
+    Record record;
+    record.level = l;
+    record.length = buf.size();
+    std::memcpy(record.text, buf.data(), record.length);
+    writer().push(std::move(record));
+}
+
+void flush()
+{
+    writer().drain();
+}
+
+}; // namespace log
+
+}; // namespace util
+
+}; // namespace sword
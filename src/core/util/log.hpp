@@ -0,0 +1,59 @@
+#ifndef UTIL_LOG_HPP
+#define UTIL_LOG_HPP
+
+//imp: util/log.cpp
+
+// SWD_LOG(level, a << b << c)
+// levels below SWD_LOG_LEVEL are compiled out. past that there is a runtime
+// level, and only if that passes is the message formatted, into a per thread
+// buffer that gets copied into a lock free ring. a background thread does the
+// actual writing, so the frame loop and input threads never wait on the
+// terminal. a full ring drops the record and counts it
+
+#include <cstddef>
+#include <ostream>
+
+#ifndef SWD_LOG_LEVEL
+#define SWD_LOG_LEVEL 1 //debug
+#endif
+
+namespace sword
+{
+
+namespace util
+{
+
+namespace log
+{
+
+enum class Level : int { trace = 0, debug = 1, info = 2, warn = 3, error = 4, off = 5 };
+
+constexpr Level compiledLevel = static_cast<Level>(SWD_LOG_LEVEL);
+
+bool enabled(Level);
+void setLevel(Level);
+
+// format into the stream beginRecord hands back, then call endRecord on the
+// same thread. messages longer than a record are cut short
+std::ostream& beginRecord();
+void endRecord(Level);
+
+// blocks until everything logged so far has been written
+void flush();
+
+}; // namespace log
+
+}; // namespace util
+
+}; // namespace sword
+
+#define SWD_LOG(level, msg) do { \
+    if constexpr (::sword::util::log::Level::level >= ::sword::util::log::compiledLevel) \
+        if (::sword::util::log::enabled(::sword::util::log::Level::level)) \
+        { \
+            ::sword::util::log::beginRecord() << msg; \
+            ::sword::util::log::endRecord(::sword::util::log::Level::level); \
+        } \
+    } while (0);
+
+#endif /* end of include guard: UTIL_LOG_HPP */
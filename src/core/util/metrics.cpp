@@ -0,0 +1,229 @@
+#include "metrics.hpp"
+#include <util/stringutil.hpp>
+#include <fstream>
+#include <iomanip>
+
+namespace sword
+{
+
+namespace util
+{
+
+namespace metrics
+{
+
+size_t Histogram::bucketOf(uint64_t value)
+{
+    if (value < 4) return value;
+    int msb = 63 - __builtin_clzll(value);
+    size_t sub = (value >> (msb - 2)) & 3;
+    return (msb - 1) * 4 + sub;
+}
+
+uint64_t Histogram::bucketFloor(size_t bucket)
+{
+    if (bucket < 4) return bucket;
+    int msb = bucket / 4 + 1;
+    return uint64_t(4 + bucket % 4) << (msb - 2);
+}
+
+void Histogram::record(uint64_t value)
+{
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    auto prev = max.load(std::memory_order_relaxed);
+    while (value > prev && !max.compare_exchange_weak(prev, value, std::memory_order_relaxed));
+}
+
+Histogram::Summary Histogram::summarize() const
+{
+    std::array<uint64_t, BucketCount> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < BucketCount; i++)
+    {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    Summary s;
+    s.count = total;
+    if (total == 0) return s;
+    s.mean = double(sum.load(std::memory_order_relaxed)) / count.load(std::memory_order_relaxed);
+    s.max = max.load(std::memory_order_relaxed);
+    auto quantile = [&](double q)
+    {
+        uint64_t rank = q * (total - 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BucketCount; i++)
+        {
+            seen += counts[i];
+            if (seen <= rank) continue;
+            if (i + 1 == BucketCount) return s.max;
+            return std::min(bucketFloor(i) + (bucketFloor(i + 1) - bucketFloor(i)) / 2, s.max); //middle of the bucket
+        }
+        return s.max;
+    };
+    s.p50 = quantile(0.5);
+    s.p90 = quantile(0.9);
+    s.p99 = quantile(0.99);
+    return s;
+}
+
+Watch::Watch(Watch&& other) : id{other.id}
+{
+    other.id = 0;
+}
+
+Watch& Watch::operator=(Watch&& other)
+{
+    if (this != &other)
+    {
+        if (id) registry().unwatch(id);
+        id = other.id;
+        other.id = 0;
+    }
+    return *this;
+}
+
+Watch::~Watch()
+{
+    if (id) registry().unwatch(id);
+}
+
+Registry::~Registry()
+{
+    stopRecording();
+}
+
+Counter& Registry::counter(const std::string& name)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto& slot = counters[name];
+    if (!slot) slot = std::make_unique<Counter>();
+    return *slot;
+}
+
+Gauge& Registry::gauge(const std::string& name)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto& slot = gauges[name];
+    if (!slot) slot = std::make_unique<Gauge>();
+    return *slot;
+}
+
+Histogram& Registry::histogram(const std::string& name)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto& slot = histograms[name];
+    if (!slot) slot = std::make_unique<Histogram>();
+    return *slot;
+}
+
+Watch Registry::watch(const std::string& name, std::function<int64_t()> sample)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto id = nextWatchId++;
+    watches.emplace(id, std::make_pair(name, std::move(sample)));
+    return Watch(id);
+}
+
+void Registry::unwatch(uint64_t id)
+{
+    std::lock_guard<std::mutex> guard(lock); // also waits out a snapshot that may be sampling it
+    watches.erase(id);
+}
+
+std::vector<Reading> Registry::snapshot() const
+{
+    std::vector<Reading> readings;
+    std::lock_guard<std::mutex> guard(lock);
+    for (const auto& [name, c] : counters)
+        readings.push_back({name, Kind::counter, c->get(), {}});
+    for (const auto& [name, g] : gauges)
+        readings.push_back({name, Kind::gauge, g->get(), {}});
+    for (const auto& [id, w] : watches)
+        readings.push_back({w.first, Kind::gauge, w.second(), {}});
+    for (const auto& [name, h] : histograms)
+        readings.push_back({name, Kind::histogram, 0, h->summarize()});
+    return readings;
+}
+
+void Registry::print(std::ostream& os) const
+{
+    auto readings = snapshot();
+    os << util::makeHeader("Stats") << '\n';
+    for (const auto& r : readings)
+    {
+        os << std::left << std::setw(36) << r.name;
+        if (r.kind != Kind::histogram)
+            os << r.value << '\n';
+        else
+            os << "n " << r.summary.count
+               << "  mean " << std::fixed << std::setprecision(1) << r.summary.mean
+               << "  p50 " << r.summary.p50
+               << "  p90 " << r.summary.p90
+               << "  p99 " << r.summary.p99
+               << "  max " << r.summary.max << '\n';
+    }
+    os << std::right << std::defaultfloat;
+}
+
+bool Registry::startRecording(const std::string& path, std::chrono::milliseconds period)
+{
+    stopRecording();
+    auto os = std::make_shared<std::ofstream>(path, std::ios::app);
+    if (!os->is_open())
+        return false;
+    if (os->tellp() == 0)
+        *os << "time_ms,name,value\n";
+    {
+        std::lock_guard<std::mutex> guard(recordLock);
+        recording = true;
+    }
+    recorder = std::thread([this, os, period]()
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> guard(recordLock);
+        while (!recordWake.wait_for(guard, period, [this]() { return !recording; }))
+        {
+            auto t = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            for (const auto& r : snapshot())
+            {
+                if (r.kind != Kind::histogram)
+                {
+                    *os << t << ',' << r.name << ',' << r.value << '\n';
+                    continue;
+                }
+                *os << t << ',' << r.name << ".count," << r.summary.count << '\n'
+                    << t << ',' << r.name << ".p50," << r.summary.p50 << '\n'
+                    << t << ',' << r.name << ".p99," << r.summary.p99 << '\n'
+                    << t << ',' << r.name << ".max," << r.summary.max << '\n';
+            }
+            os->flush();
+        }
+    });
+    return true;
+}
+
+void Registry::stopRecording()
+{
+    {
+        std::lock_guard<std::mutex> guard(recordLock);
+        recording = false;
+    }
+    recordWake.notify_all();
+    if (recorder.joinable())
+        recorder.join();
+}
+
+Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+}; // namespace metrics
+
+}; // namespace util
+
+}; // namespace sword
@@ -0,0 +1,168 @@
+#ifndef UTIL_METRICS_HPP
+#define UTIL_METRICS_HPP
+
+//imp: util/metrics.cpp
+
+// one registry of named counters, gauges and histograms for the whole
+// program. look a metric up once and keep the reference; updating it is a
+// relaxed atomic. values that already live somewhere else (pool occupancy,
+// queue depth) are watched instead: the registry calls back for them only
+// when it takes a snapshot.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sword
+{
+
+namespace util
+{
+
+namespace metrics
+{
+
+class Counter
+{
+public:
+    void add(int64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t get() const { return value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<int64_t> value{0};
+};
+
+class Gauge
+{
+public:
+    void set(int64_t n) { value.store(n, std::memory_order_relaxed); }
+    void add(int64_t n) { value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t get() const { return value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<int64_t> value{0};
+};
+
+// log-linear buckets: four per power of two, so quantiles are good to
+// within about 25%
+class Histogram
+{
+public:
+    static constexpr size_t BucketCount = 256;
+
+    struct Summary
+    {
+        uint64_t count{0};
+        double mean{0};
+        uint64_t p50{0};
+        uint64_t p90{0};
+        uint64_t p99{0};
+        uint64_t max{0};
+    };
+
+    void record(uint64_t value);
+    Summary summarize() const;
+
+private:
+    std::array<std::atomic<uint64_t>, BucketCount> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+
+    static size_t bucketOf(uint64_t value);
+    static uint64_t bucketFloor(size_t bucket);
+};
+
+// unregisters its watched value when it goes away, so declare it after
+// whatever it watches
+class Watch
+{
+public:
+    Watch() = default;
+    Watch(Watch&&);
+    Watch& operator=(Watch&&);
+    ~Watch();
+    Watch(const Watch&) = delete;
+    Watch& operator=(const Watch&) = delete;
+private:
+    friend class Registry;
+    Watch(uint64_t id) : id{id} {}
+    uint64_t id{0};
+};
+
+enum class Kind : uint8_t { counter, gauge, histogram };
+
+struct Reading
+{
+    std::string name;
+    Kind kind;
+    int64_t value{0};
+    Histogram::Summary summary;
+};
+
+class Registry
+{
+public:
+    ~Registry();
+
+    Counter& counter(const std::string& name);
+    Gauge& gauge(const std::string& name);
+    Histogram& histogram(const std::string& name);
+    [[nodiscard]] Watch watch(const std::string& name, std::function<int64_t()> sample);
+
+    std::vector<Reading> snapshot() const;
+    void print(std::ostream&) const;
+
+    // appends a csv snapshot (time_ms,name,value) to path every period.
+    // returns false if the file could not be opened
+    bool startRecording(const std::string& path, std::chrono::milliseconds period);
+    void stopRecording();
+
+private:
+    friend class Watch;
+    void unwatch(uint64_t id);
+
+    mutable std::mutex lock;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    std::map<uint64_t, std::pair<std::string, std::function<int64_t()>>> watches;
+    uint64_t nextWatchId{1};
+
+    std::mutex recordLock;
+    std::condition_variable recordWake;
+    std::thread recorder;
+    bool recording{false};
+};
+
+Registry& registry();
+
+template <typename P>
+void watchPool(std::vector<Watch>& watches, const std::string& name, const P& pool)
+{
+    watches.push_back(registry().watch(name + ".inUse", [&pool]() { return int64_t(pool.inUse()); }));
+    watches.push_back(registry().watch(name + ".highWater", [&pool]() { return int64_t(pool.highWaterMark()); }));
+}
+
+template <typename Duration>
+inline uint64_t toMicros(Duration d)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    return us > 0 ? us : 0;
+}
+
+}; // namespace metrics
+
+}; // namespace util
+
+}; // namespace sword
+
+#endif /* end of include guard: UTIL_METRICS_HPP */
@@ -1,10 +1,12 @@
 #ifndef UTIL_OUTFORMAT_HPP
 #define UTIL_OUTFORMAT_HPP
 
+#include <util/log.hpp>
+
 namespace sword
 {
 
-#define SWD_THREAD_MSG(msg) std::cout << "////// " << msg << '\n';
+#define SWD_THREAD_MSG(msg) SWD_LOG(info, "////// " << msg)
 
 }; // namespace sword
 
@@ -0,0 +1,112 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sword
+{
+
+namespace util
+{
+
+namespace profiler
+{
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point epoch = Clock::now();
+
+    // rings outlive their threads so a dump still sees threads that have exited
+    std::mutex registryLock;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+
+    ThreadRing* registerThread()
+    {
+        std::lock_guard<std::mutex> guard(registryLock);
+        rings.push_back(std::make_unique<ThreadRing>(rings.size() + 1));
+        return rings.back().get();
+    }
+
+    struct Copy
+    {
+        const char* name;
+        int64_t begin;
+        int64_t end;
+    };
+
+    void writeEscaped(std::ofstream& os, const char* str)
+    {
+        for (; *str; str++)
+        {
+            if (*str == '"' || *str == '\\') os << '\\';
+            os << *str;
+        }
+    }
+};
+
+ThreadRing& threadRing()
+{
+    thread_local ThreadRing* ring = registerThread();
+    return *ring;
+}
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+}
+
+bool dumpChromeTrace(const std::string& path)
+{
+    std::ofstream os(path);
+    if (!os.is_open())
+        return false;
+
+    os << std::fixed << std::setprecision(3); // timestamps are in microseconds
+    os << "{\"traceEvents\":[\n";
+    bool first = true;
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (const auto& ring : rings)
+    {
+        // copy out what looks settled, then drop anything the owner lapped
+        // while we were reading
+        auto endIndex = ring->head.load(std::memory_order_acquire);
+        auto beginIndex = endIndex > ThreadRing::Capacity ? endIndex - ThreadRing::Capacity : 0;
+        std::vector<Copy> copies;
+        copies.reserve(endIndex - beginIndex);
+        for (auto i = beginIndex; i < endIndex; i++)
+        {
+            const auto& s = ring->samples[i % ThreadRing::Capacity];
+            copies.push_back({
+                    s.name.load(std::memory_order_relaxed),
+                    s.begin.load(std::memory_order_relaxed),
+                    s.end.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto lapped = ring->started.load(std::memory_order_relaxed);
+        auto firstGood = lapped > ThreadRing::Capacity ? lapped - ThreadRing::Capacity : 0;
+        for (auto i = std::max(beginIndex, firstGood); i < endIndex; i++)
+        {
+            const auto& c = copies[i - beginIndex];
+            if (!c.name) continue;
+            if (!first) os << ",\n";
+            first = false;
+            os << "{\"name\":\"";
+            writeEscaped(os, c.name);
+            os << "\",\"cat\":\"sword\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->tid
+               << ",\"ts\":" << c.begin / 1000.0
+               << ",\"dur\":" << (c.end - c.begin) / 1000.0 << "}";
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return os.good();
+}
+
+}; // namespace profiler
+
+}; // namespace util
+
+}; // namespace sword
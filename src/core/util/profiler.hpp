@@ -0,0 +1,91 @@
+#ifndef UTIL_PROFILER_HPP
+#define UTIL_PROFILER_HPP
+
+//imp: util/profiler.cpp
+
+// scoped cpu timing markers. each thread records into its own ring buffer,
+// and dumpChromeTrace writes whatever the rings still hold as chrome
+// trace-event json (load it in chrome://tracing or ui.perfetto.dev).
+// build without SWD_PROFILE and the markers compile to nothing.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace sword
+{
+
+namespace util
+{
+
+namespace profiler
+{
+
+// names must outlive the profiler: string literals or Command::getName()
+struct Sample
+{
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> begin{0};
+    std::atomic<int64_t> end{0};
+};
+
+class ThreadRing
+{
+public:
+    static constexpr size_t Capacity = 1 << 14;
+
+    ThreadRing(uint32_t tid) : tid{tid} {}
+
+    void record(const char* name, int64_t begin, int64_t end)
+    {
+        auto h = head.load(std::memory_order_relaxed);
+        started.store(h + 1, std::memory_order_relaxed); // lets a dump spot a slot we're overwriting
+        std::atomic_thread_fence(std::memory_order_release);
+        auto& s = samples[h % Capacity];
+        s.name.store(name, std::memory_order_relaxed);
+        s.begin.store(begin, std::memory_order_relaxed);
+        s.end.store(end, std::memory_order_relaxed);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    const uint32_t tid;
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> started{0};
+    Sample samples[Capacity];
+};
+
+ThreadRing& threadRing();
+int64_t now(); // ns since the profiler started
+
+// returns false if the file could not be opened
+bool dumpChromeTrace(const std::string& path);
+
+class Scope
+{
+public:
+    Scope(const char* name) : name{name}, begin{now()} {}
+    ~Scope() { threadRing().record(name, begin, now()); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    const char* name;
+    int64_t begin;
+};
+
+}; // namespace profiler
+
+}; // namespace util
+
+}; // namespace sword
+
+#define SWD_PROFILE_CAT_(a, b) a##b
+#define SWD_PROFILE_CAT(a, b) SWD_PROFILE_CAT_(a, b)
+
+#ifdef SWD_PROFILE
+#define SWD_PROFILE_SCOPE(name) ::sword::util::profiler::Scope SWD_PROFILE_CAT(swdProfileScope, __LINE__){name};
+#else
+#define SWD_PROFILE_SCOPE(name)
+#endif
+
+#endif /* end of include guard: UTIL_PROFILER_HPP */
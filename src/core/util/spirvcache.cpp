@@ -0,0 +1,104 @@
+#include "spirvcache.hpp"
+#include "defs.hpp"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+namespace sword
+{
+
+namespace util
+{
+
+static constexpr uint32_t spirvMagic = 0x07230203;
+
+SpirvCache::SpirvCache(std::filesystem::path dir) :
+    dir{dir}
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec)
+        std::cerr << "SpirvCache: could not create " << dir << ": " << ec.message() << '\n';
+}
+
+// fnv-1a over the parts, each followed by its length so "ab","c" and "a","bc" differ
+SpirvCache::Key SpirvCache::key(std::initializer_list<std::string_view> parts)
+{
+    Key hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const char* bytes, size_t n) {
+        for (size_t i = 0; i < n; i++) 
+        {
+            hash ^= static_cast<unsigned char>(bytes[i]);
+            hash *= 0x100000001b3ull;
+        }
+    };
+    for (auto part : parts) 
+    {
+        uint64_t size = part.size();
+        mix(part.data(), part.size());
+        mix(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    return hash;
+}
+
+std::filesystem::path SpirvCache::entryPath(Key key) const
+{
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+    return dir / name;
+}
+
+bool SpirvCache::load(Key key, std::vector<uint32_t>& code) const
+{
+    std::ifstream f(entryPath(key), std::ios::binary | std::ios::ate);
+    if (!f)
+        return false;
+    auto size = static_cast<size_t>(f.tellg());
+    if (size == 0 || size % sizeof(uint32_t))
+        return false;
+    code.resize(size / sizeof(uint32_t));
+    f.seekg(0);
+    f.read(reinterpret_cast<char*>(code.data()), size);
+    if (!f || code[0] != spirvMagic)
+    {
+        code.clear();
+        return false;
+    }
+    return true;
+}
+
+void SpirvCache::store(Key key, const uint32_t* code, size_t wordCount) const
+{
+    static std::atomic<uint32_t> serial{0};
+    auto path = entryPath(key);
+    auto tmp = path;
+    tmp += "." + std::to_string(getpid()) + "." + std::to_string(serial++) + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(code), wordCount * sizeof(uint32_t));
+        if (!f)
+        {
+            std::cerr << "SpirvCache: could not write " << tmp << '\n';
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec)
+    {
+        std::cerr << "SpirvCache: could not store " << path << ": " << ec.message() << '\n';
+        std::filesystem::remove(tmp, ec);
+    }
+}
+
+SpirvCache& spirvCache()
+{
+    static SpirvCache cache{SPIRV_CACHE};
+    return cache;
+}
+
+}; // namespace util
+
+}; // namespace sword
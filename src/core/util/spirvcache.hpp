@@ -0,0 +1,43 @@
+#ifndef UTIL_SPIRVCACHE_HPP
+#define UTIL_SPIRVCACHE_HPP
+
+//imp: util/spirvcache.cpp
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+
+namespace sword
+{
+
+namespace util
+{
+
+// compiled spirv kept on disk, one file per key. the key is a hash of
+// everything that went into the compile, so an entry never goes stale: a
+// changed source or include just hashes somewhere else. entries are written
+// to a temporary and renamed into place, so readers on other threads (or in
+// other processes) only ever see whole files
+class SpirvCache
+{
+public:
+    using Key = uint64_t;
+
+    explicit SpirvCache(std::filesystem::path dir);
+    static Key key(std::initializer_list<std::string_view> parts);
+    bool load(Key, std::vector<uint32_t>& code) const;
+    void store(Key, const uint32_t* code, size_t wordCount) const;
+private:
+    std::filesystem::path entryPath(Key) const;
+    std::filesystem::path dir;
+};
+
+SpirvCache& spirvCache(); //the one under SPIRV_CACHE
+
+}; // namespace util
+
+}; // namespace sword
+
+#endif /* end of include guard: UTIL_SPIRVCACHE_HPP */
@@ -0,0 +1,100 @@
+#include "threadpool.hpp"
+#include <cassert>
+
+namespace sword
+{
+
+namespace util
+{
+
+namespace
+{
+    thread_local const ThreadPool* currentPool{nullptr};
+    thread_local size_t currentIndex{0};
+};
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    if (threadCount == 0) threadCount = 1;
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++)
+        workers.push_back(std::make_unique<Worker>());
+    threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++)
+        threads.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void ThreadPool::submit(Job job)
+{
+    assert(job && "Null job submitted");
+    size_t index = (currentPool == this) ? currentIndex : next.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    {
+        std::lock_guard<std::mutex> guard(workers[index]->lock);
+        workers[index]->jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleepLock); // so a worker can't miss this between checking and sleeping
+        queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::tryPop(size_t index, Job& job)
+{
+    {
+        auto& own = *workers[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.jobs.empty())
+        {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers.size(); i++)
+    {
+        auto& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty())
+        {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t index)
+{
+    currentPool = this;
+    currentIndex = index;
+    while (1)
+    {
+        Job job;
+        if (tryPop(index, job))
+        {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            job();
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wakeUp.wait(guard, [this]() { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+        if (stopping) return;
+    }
+}
+
+}; // namespace util
+
+}; // namespace sword
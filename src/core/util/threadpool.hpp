@@ -0,0 +1,62 @@
+#ifndef UTIL_THREADPOOL_HPP
+#define UTIL_THREADPOOL_HPP
+
+//imp: util/threadpool.cpp
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sword
+{
+
+namespace util
+{
+
+// fixed set of workers, each with its own deque.
+// a worker takes from the back of its own deque and steals from the front
+// of the others when it runs dry. jobs submitted from outside the pool are
+// dealt round robin.
+class ThreadPool
+{
+public:
+    using Job = std::function<void()>;
+
+    explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Job);
+    size_t size() const { return threads.size(); }
+
+private:
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex sleepLock;
+    std::condition_variable wakeUp;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> next{0};
+    bool stopping{false};
+
+    void run(size_t index);
+    bool tryPop(size_t index, Job&);
+};
+
+}; // namespace util
+
+}; // namespace sword
+
+#endif /* end of include guard: UTIL_THREADPOOL_HPP */
@@ -1,23 +1,66 @@
 #include <application.hpp>
 #include <fstream>
+#include <cstring>
 
+// sword [logfile [popEvents]] [--headless] [--pace recorded|fixed|fast] [--fps n] [--report file]
+//       [--seek event] [--checkpoint]
 int main(int argc, const char *argv[])
 {
     std::string logfile{"eventlog"};
     int popEvents{0};
+    sword::ReplaySettings replay;
+    int positional{0};
     std::cout << "Arg count is " << argc << std::endl;
-    if (argc >= 2) 
+    for (int i = 1; i < argc; i++)
     {
-        const char* file = argv[1];
-        logfile = file;
-        std::cout << "Logfile is " << logfile << std::endl;
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--headless") == 0)
+            replay.headless = true;
+        else if (strcmp(arg, "--pace") == 0 && hasValue)
+        {
+            std::string pace = argv[++i];
+            if (pace == "recorded") replay.pace = sword::ReplayPace::recorded;
+            else if (pace == "fixed") replay.pace = sword::ReplayPace::fixed;
+            else if (pace == "fast") replay.pace = sword::ReplayPace::fast;
+            else
+            {
+                std::cerr << "Unknown pace " << pace << ", expected recorded, fixed or fast" << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(arg, "--fps") == 0 && hasValue)
+            replay.fps = atoi(argv[++i]);
+        else if (strcmp(arg, "--report") == 0 && hasValue)
+            replay.report = argv[++i];
+        else if (strcmp(arg, "--seek") == 0 && hasValue)
+            replay.seek = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(arg, "--checkpoint") == 0)
+            replay.checkpoints = true;
+        else if (positional == 0)
+        {
+            logfile = arg;
+            positional++;
+            std::cout << "Logfile is " << logfile << std::endl;
+        }
+        else if (positional == 1)
+        {
+            popEvents = atoi(arg);
+            positional++;
+            std::cout << "Pop events: " << popEvents << std::endl;
+        }
+        else
+        {
+            std::cerr << "Unexpected argument " << arg << std::endl;
+            return 1;
+        }
     }
-    if (argc == 3)
+    if (replay.headless && logfile == "eventlog")
     {
-        popEvents = atoi(argv[2]);
-        std::cout << "Pop events: " << popEvents << std::endl;
+        std::cerr << "--headless needs a log to replay" << std::endl;
+        return 1;
     }
-    sword::Application app{800, 800, logfile, popEvents};
+    sword::Application app{800, 800, logfile, popEvents, replay};
     app.run(true);
     return 0;
 }
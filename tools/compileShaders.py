@@ -1,11 +1,16 @@
 import subprocess
 import os
+import struct
 
 base_dir = os.path.join( os.path.dirname(__file__), '..')
 shaders_dir = os.path.join(base_dir, "src", "shaders")
 out_dir = os.path.join(base_dir, "build", "shaders")
+bundle_path = os.path.join(base_dir, "build", "shaders.bundle")
 glslc_path = '/home/michaelb/dev/Vulkan/1.1.126.0/x86_64/bin/glslc'
 
+bundle_magic = 0x42535753 # "SWSB", see render/shaderbundle.hpp
+bundle_version = 1
+
 
 def compileShaders(shader_dir, out_dir, glslc_path):
     shaders = []
@@ -21,6 +26,35 @@ def compileShaders(shader_dir, out_dir, glslc_path):
     for shader in shaders:
         subprocess.run([glslc_path, shader[0], '-o', shader[1]])
 
+# packs every .spv in spv_dir into one file the renderer maps at startup
+def writeBundle(spv_dir, bundle_path):
+    blobs = []
+    for f in sorted(os.listdir(spv_dir)):
+        if f.endswith('.spv'):
+            with open(os.path.join(spv_dir, f), 'rb') as spv:
+                blobs.append((f.encode(), spv.read()))
+
+    names_offset = 16 + 16 * len(blobs)
+    names = b''.join(name for name, _ in blobs)
+    code_offset = (names_offset + len(names) + 3) & ~3
+
+    entries = b''
+    code = b''
+    name_pos = names_offset
+    for name, blob in blobs:
+        entries += struct.pack('<4I', name_pos, len(name), code_offset + len(code), len(blob))
+        name_pos += len(name)
+        code += blob + b'\0' * (-len(blob) % 4)
+
+    with open(bundle_path + '.tmp', 'wb') as out:
+        out.write(struct.pack('<4I', bundle_magic, bundle_version, len(blobs), 0))
+        out.write(entries)
+        out.write(names)
+        out.write(b'\0' * (code_offset - names_offset - len(names)))
+        out.write(code)
+    os.replace(bundle_path + '.tmp', bundle_path)
+
 dirs = [d[0] for d in os.walk(shaders_dir)]
 for d in dirs:
     compileShaders(d, out_dir, glslc_path)
+writeBundle(out_dir, bundle_path)
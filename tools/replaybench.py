@@ -0,0 +1,38 @@
+import subprocess
+import sys
+import os
+
+# replays every log under tests/ and logs/ headless and collects the timings
+# each run appends into one csv. extra arguments go to sword, e.g. --pace fast
+
+base_dir = os.path.join( os.path.dirname(__file__), '..')
+sword_path = os.path.join(base_dir, "bin", "sword")
+log_dirs = [os.path.join(base_dir, "tests"), os.path.join(base_dir, "logs")]
+report_path = os.path.join(base_dir, "build", "replaybench.csv")
+
+
+def findLogs(log_dirs):
+    logs = []
+    for log_dir in log_dirs:
+        for root, dirs, files in os.walk(log_dir):
+            for f in sorted(files):
+                logs.append(os.path.join(root, f))
+    return logs
+
+
+def runLogs(logs, extra_args):
+    failed = []
+    for log in logs:
+        print("replaying", log)
+        args = [sword_path, log, '--headless', '--report', report_path] + extra_args
+        if subprocess.run(args, cwd=base_dir).returncode != 0:
+            failed.append(log)
+    return failed
+
+if os.path.exists(report_path):
+    os.remove(report_path)
+failed = runLogs(findLogs(log_dirs), sys.argv[1:])
+print("timings in", report_path)
+for log in failed:
+    print("failed:", log)
+sys.exit(1 if failed else 0)